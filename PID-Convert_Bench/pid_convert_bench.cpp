@@ -0,0 +1,659 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_convert_bench.cpp
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Micro-benchmarks for the .PID decoder and the encoders
+ *
+ *  DETAILS:
+ *      Stand-alone console program (not linked into the .d5c) that times
+ *      every stage of a conversion on a synthetic corpus built in memory:
+ *      tiny sprites, large raw-coded backgrounds, heavily transparent RLE
+ *      images and mirrored / inverted ones, plus any real .pid files given
+ *      with --corpus. Stages: parse_header, load_palette, decompress,
+ *      scanline decode, SaveToBMP / SaveToTGA / SaveToTGARLE /
+ *      SaveToRAW8, SaveToPNG in every mode and preset, the complete
+ *      ConvertPidData path and PidEncoder::encode back to .PID with
+ *      greedy and optimal packing.
+ *      Before the encode stages each case is checked once, untimed: the
+ *      decompress, scanline and decompress_parallel planes must equal the
+ *      PidDecoder::decode plane, both packings must decode back to it, and
+ *      no Balanced PNG may be larger than the Fast one.
+ *      Output goes to MockHostStream, an in-memory stand-in for
+ *      DelphiTStreamWrapper with the same interface that also counts host
+ *      calls. Reports ns/pixel, MB/s (bytes consumed by decode stages,
+ *      bytes produced by encode stages), heap allocations per call,
+ *      counted by replacing the global operator new, and, for the stages
+ *      that write to the mock, host stream calls per call.
+ * ============================================================================
+ */
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <string>
+#include <vector>
+#include "../PID-Convert_DU/pid_arena.h"
+#include "../PID-Convert_DU/pid_convert.h"
+#include "../PID-Convert_DU/pid_decoder.h"
+#include "../PID-Convert_DU/pid_deflate.h"
+#include "../PID-Convert_DU/pid_encoders.h"
+#include "../PID-Convert_DU/pid_encoder.h"
+#include "../PID-Convert_DU/pid_palette.h"
+
+namespace fs = std::filesystem;
+
+
+// ===================================================================
+// Allocation counter (global operator new replacement)
+// ===================================================================
+static std::atomic<std::uint64_t> g_allocations{ 0 };
+
+void *operator new(std::size_t size)
+{
+    ++g_allocations;
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+
+// ===================================================================
+// Mock host stream
+// - Same surface as DelphiTStreamWrapper (read, write, seek_abs,
+//   position, get_size) on a growable buffer whose capacity survives
+//   rewind(), so repeated iterations do not allocate.
+// ===================================================================
+class MockHostStream
+{
+public:
+    std::size_t read(void *buffer, std::size_t count)
+    {
+        ++fCalls;
+        const std::size_t n = (fPos < fData.size()) ? (std::min)(count, fData.size() - fPos) : 0;
+        if (n) std::memcpy(buffer, fData.data() + fPos, n);
+        fPos += n;
+        return n;
+    }
+
+    std::size_t write(const void *buffer, std::size_t count)
+    {
+        ++fCalls;
+        if (fPos + count > fData.size()) fData.resize(fPos + count);
+        std::memcpy(fData.data() + fPos, buffer, count);
+        fPos += count;
+        return count;
+    }
+
+    bool seek_abs(std::int64_t offset)
+    {
+        ++fCalls;
+        if (offset < 0) return false;
+        fPos = static_cast<std::size_t>(offset);
+        return true;
+    }
+
+    std::int64_t position() const { return static_cast<std::int64_t>(fPos); }
+    std::int64_t get_size() const { return static_cast<std::int64_t>(fData.size()); }
+
+    // Empties the stream for the next iteration, keeping the capacity
+    void rewind() { fData.clear(); fPos = 0; fCalls = 0; }
+
+    std::size_t size() const { return fData.size(); }
+    std::uint64_t calls() const { return fCalls; }
+
+private:
+    std::vector<unsigned char> fData;
+    std::size_t fPos = 0;
+    std::uint64_t fCalls = 0;
+};
+
+
+// ===================================================================
+// Synthetic corpus
+// - Index planes are generated top-down, then stored in file order
+//   (mirrored rows reversed, inverted images bottom-up) and coded with
+//   the same RLE / raw rules PidDecoder reads.
+// ===================================================================
+struct BenchCase
+{
+    std::string name;
+    std::vector<unsigned char> pid;     // complete .PID file
+    int width = 0;
+    int height = 0;
+};
+
+struct SynthSpec
+{
+    const char *name;
+    int width;
+    int height;
+    int flags;                          // PID_FLAG_* bits
+    int transparentPercent;             // share of index 0 pixels
+    int meanRun;                        // average run length of one colour
+};
+
+static std::uint32_t NextRandom(std::uint32_t &state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+// Top-down index plane made of horizontal runs; index 0 only where transparentPercent asks for it
+static std::vector<unsigned char> SynthPlane(const SynthSpec &spec, std::uint32_t seed)
+{
+    std::vector<unsigned char> plane(static_cast<std::size_t>(spec.width) * spec.height);
+    std::uint32_t rnd = seed;
+    std::size_t i = 0;
+    while (i < plane.size())
+    {
+        const std::size_t run = 1 + NextRandom(rnd) % static_cast<std::uint32_t>(2 * spec.meanRun);
+        const bool clear = static_cast<int>(NextRandom(rnd) % 100) < spec.transparentPercent;
+        const unsigned char value = clear ? 0 : static_cast<unsigned char>(1 + NextRandom(rnd) % 255);
+        for (std::size_t n = 0; n < run && i < plane.size(); ++n) plane[i++] = value;
+    }
+    return plane;
+}
+
+static void CodeRle(const std::vector<unsigned char> &stored, std::vector<unsigned char> &out)
+{
+    std::size_t i = 0;
+    while (i < stored.size())
+    {
+        std::size_t n = 0;
+        if (stored[i] == 0)
+        {
+            while (i + n < stored.size() && stored[i + n] == 0 && n < 127) ++n;
+            out.push_back(static_cast<unsigned char>(128 + n));
+        }
+        else
+        {
+            while (i + n < stored.size() && stored[i + n] != 0 && n < 128) ++n;
+            out.push_back(static_cast<unsigned char>(n));
+            out.insert(out.end(), stored.begin() + i, stored.begin() + i + n);
+        }
+        i += n;
+    }
+}
+
+static void CodeRaw(const std::vector<unsigned char> &stored, std::vector<unsigned char> &out)
+{
+    std::size_t i = 0;
+    while (i < stored.size())
+    {
+        const unsigned char v = stored[i];
+        std::size_t n = 1;
+        while (i + n < stored.size() && stored[i + n] == v && n < 63) ++n;
+        if (n > 1 || v > 192)
+        {
+            out.push_back(static_cast<unsigned char>(192 + n));
+            out.push_back(v);
+        }
+        else
+        {
+            out.push_back(v);
+        }
+        i += n;
+    }
+}
+
+static BenchCase Synthesize(const SynthSpec &spec, std::uint32_t seed)
+{
+    const std::vector<unsigned char> plane = SynthPlane(spec, seed);
+    const std::size_t w = static_cast<std::size_t>(spec.width);
+
+    // File order: flips undone the way the decoder redoes them
+    std::vector<unsigned char> stored(plane.size());
+    for (int r = 0; r < spec.height; ++r)
+    {
+        const int y = (spec.flags & PID_FLAG_INVERT) ? spec.height - 1 - r : r;
+        const unsigned char *src = plane.data() + static_cast<std::size_t>(y) * w;
+        unsigned char *dst = stored.data() + static_cast<std::size_t>(r) * w;
+        if (spec.flags & PID_FLAG_MIRROR)
+            for (std::size_t x = 0; x < w; ++x) dst[x] = src[w - 1 - x];
+        else
+            std::memcpy(dst, src, w);
+    }
+
+    BenchCase bench;
+    bench.name = spec.name;
+    bench.width = spec.width;
+    bench.height = spec.height;
+
+    PIDHeader header = {};
+    header.ID = 10;
+    header.Flags = spec.flags;
+    header.Width = spec.width;
+    header.Height = spec.height;
+    bench.pid.resize(sizeof(header));
+    std::memcpy(bench.pid.data(), &header, sizeof(header));
+
+    if (spec.flags & PID_FLAG_RLE) CodeRle(stored, bench.pid);
+    else                           CodeRaw(stored, bench.pid);
+
+    if (spec.flags & PID_FLAG_PALETTE)
+    {
+        std::uint32_t rnd = seed ^ 0x9E3779B9u;
+        for (int i = 0; i < 768; ++i) bench.pid.push_back(static_cast<unsigned char>(NextRandom(rnd)));
+    }
+    return bench;
+}
+
+static std::vector<BenchCase> SyntheticCorpus()
+{
+    static const SynthSpec specs[] = {
+        { "sprite-32x32",        32,   32, PID_FLAG_TRANSPARENT | PID_FLAG_RLE,                    40,  6 },
+        { "sprite-64x48",        64,   48, PID_FLAG_TRANSPARENT | PID_FLAG_RLE | PID_FLAG_MIRROR,  40,  6 },
+        { "background-1024x768", 1024, 768, PID_FLAG_PALETTE,                                      0,   12 },
+        { "background-2048x1536",2048, 1536, 0,                                                    0,   24 },
+        { "transparent-512x512", 512,  512, PID_FLAG_TRANSPARENT | PID_FLAG_RLE,                   90,  16 },
+        { "flipped-rle-256x256", 256,  256, PID_FLAG_TRANSPARENT | PID_FLAG_RLE | PID_FLAG_MIRROR | PID_FLAG_INVERT, 30, 8 },
+        { "flipped-raw-512x384", 512,  384, PID_FLAG_MIRROR | PID_FLAG_INVERT | PID_FLAG_PALETTE,   0,   4 },
+    };
+    std::vector<BenchCase> corpus;
+    std::uint32_t seed = 12345;
+    for (const SynthSpec &spec : specs) corpus.push_back(Synthesize(spec, seed++));
+    return corpus;
+}
+
+// Real files: every *.pid below dir
+static void AddDirectory(const fs::path &dir, std::vector<BenchCase> &corpus)
+{
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir, ec), end; it != end && !ec; it.increment(ec))
+    {
+        if (!it->is_regular_file(ec) || _stricmp(it->path().extension().string().c_str(), ".pid") != 0) continue;
+        std::ifstream in(it->path(), std::ios::binary);
+        BenchCase bench;
+        bench.pid.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        PidInfo info;
+        if (!PidDecoder::parse_header(bench.pid.data(), bench.pid.size(), info)) continue;
+        bench.name = it->path().filename().u8string();
+        bench.width = info.width;
+        bench.height = info.height;
+        corpus.push_back(std::move(bench));
+    }
+}
+
+
+// ===================================================================
+// Measurement
+// ===================================================================
+struct BenchOptions
+{
+    double minSeconds = 0.2;            // per stage
+    std::string filter;                 // substring of "case/stage"
+    std::vector<fs::path> corpusDirs;
+    bool csv = false;
+};
+
+struct StageResult
+{
+    std::uint64_t iterations = 0;
+    double nsPerCall = 0.0;
+    double nsPerPixel = 0.0;
+    double mbPerSecond = 0.0;
+    double allocsPerCall = 0.0;
+    double hostCallsPerCall = -1.0;     // < 0: the stage does not use the host stream
+};
+
+// Runs fn (returning the bytes it consumed or produced, 0 on failure)
+// until minSeconds have passed (at least once); one untimed warm-up call
+// first, so arenas, pools and palette tables are in their steady state.
+// With host set, fn rewinds that stream first and its calls() are summed
+static bool Measure(const BenchOptions &opt, std::size_t pixels, const std::function<std::size_t()> &fn,
+                    const MockHostStream *host, StageResult &result)
+{
+    if (fn() == 0) return false;
+
+    std::uint64_t iterations = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t hostCalls = 0;
+    const std::uint64_t allocs0 = g_allocations.load();
+    const auto t0 = std::chrono::steady_clock::now();
+    double seconds = 0.0;
+    do
+    {
+        const std::size_t n = fn();
+        if (n == 0) return false;
+        bytes += n;
+        if (host) hostCalls += host->calls();
+        ++iterations;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    } while (seconds < opt.minSeconds);
+    const std::uint64_t allocs = g_allocations.load() - allocs0;
+
+    result.iterations = iterations;
+    result.nsPerCall = seconds * 1e9 / static_cast<double>(iterations);
+    result.nsPerPixel = pixels ? result.nsPerCall / static_cast<double>(pixels) : 0.0;
+    result.mbPerSecond = static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds;
+    result.allocsPerCall = static_cast<double>(allocs) / static_cast<double>(iterations);
+    result.hostCallsPerCall = host ? static_cast<double>(hostCalls) / static_cast<double>(iterations) : -1.0;
+    return true;
+}
+
+static void PrintHeader(const BenchOptions &opt)
+{
+    if (opt.csv) std::printf("case,stage,iterations,ns_per_call,ns_per_pixel,mb_per_s,allocs_per_call,host_calls_per_call\n");
+    else std::printf("%-24s %-22s %9s %12s %10s %10s %8s %9s\n", "case", "stage", "iters", "ns/call", "ns/pixel", "MB/s", "allocs",
+                     "hostcalls");
+}
+
+static void PrintResult(const BenchOptions &opt, const std::string &bench, const char *stage, const StageResult &r)
+{
+    // Stages that never touch the host stream get an empty / "-" column
+    char hostCalls[32] = "";
+    if (r.hostCallsPerCall >= 0.0) std::snprintf(hostCalls, sizeof(hostCalls), "%.2f", r.hostCallsPerCall);
+    if (opt.csv)
+        std::printf("%s,%s,%llu,%.1f,%.3f,%.1f,%.2f,%s\n", bench.c_str(), stage, static_cast<unsigned long long>(r.iterations),
+                    r.nsPerCall, r.nsPerPixel, r.mbPerSecond, r.allocsPerCall, hostCalls);
+    else
+        std::printf("%-24s %-22s %9llu %12.0f %10.3f %10.1f %8.2f %9s\n", bench.c_str(), stage,
+                    static_cast<unsigned long long>(r.iterations), r.nsPerCall, r.nsPerPixel, r.mbPerSecond, r.allocsPerCall,
+                    hostCalls[0] ? hostCalls : "-");
+}
+
+
+// ===================================================================
+// Stages of one case
+// ===================================================================
+static int RunCase(const BenchOptions &opt, const BenchCase &bench)
+{
+    const unsigned char *data = bench.pid.data();
+    const std::size_t size = bench.pid.size();
+    const std::size_t pixels = static_cast<std::size_t>(bench.width) * static_cast<std::size_t>(bench.height);
+    int failures = 0;
+
+    auto stage = [&](const char *name, const std::function<std::size_t()> &fn, const MockHostStream *host = nullptr) {
+        if (!opt.filter.empty() && (bench.name + "/" + name).find(opt.filter) == std::string::npos) return;
+        StageResult r;
+        if (Measure(opt, pixels, fn, host, r)) PrintResult(opt, bench.name, name, r);
+        else { std::fprintf(stderr, "FAILED %s/%s\n", bench.name.c_str(), name); ++failures; }
+    };
+
+    // --- Decode stages (MB/s of .PID input) ---
+    stage("parse_header", [&]() -> std::size_t {
+        PidInfo info;
+        return PidDecoder::parse_header(data, size, info) ? sizeof(PIDHeader) : 0;
+    });
+
+    PidImage image;
+    if (!PidDecoder::decode(data, size, image))
+    {
+        std::fprintf(stderr, "FAILED %s (does not decode)\n", bench.name.c_str());
+        return 1;
+    }
+
+    stage("load_palette", [&]() -> std::size_t {
+        PidImage probe;
+        PidDecoder::parse_header(data, size, probe);
+        return PidDecoder::load_palette(data, size, probe) ? (image.hasPalette ? 768 : sizeof(PIDHeader)) : 0;
+    });
+
+    // decompress() covers RLE vs raw and the mirror/invert flags of the case
+    std::vector<unsigned char> plane(pixels);
+    char decodeName[32];
+    std::snprintf(decodeName, sizeof(decodeName), "decompress-%s%s%s", image.rleCompression ? "rle" : "raw",
+                  image.mirror ? "-mirror" : "", image.invert ? "-invert" : "");
+    stage(decodeName, [&]() -> std::size_t {
+        return PidDecoder::decompress(data, size, image, plane.data()) ? size : 0;
+    });
+
+    if (!image.invert)
+    {
+        stage("scanline-decode", [&]() -> std::size_t {
+            ScratchArena::Scope scratch;
+            PidScanlineDecoder rows(data, size, image);
+            for (int y = 0; y < image.height; ++y)
+                if (!rows.row(y)) return 0;
+            return size;
+        });
+    }
+
+    // --- Reference checks (untimed): every decode path must give the
+    //     PidDecoder::decode plane, both packings must decode back to it ---
+    auto check = [&](const char *name, bool ok, const char *why = "differs from decode") {
+        if (!ok) { std::fprintf(stderr, "FAILED %s/%s (%s)\n", bench.name.c_str(), name, why); ++failures; }
+    };
+    check("decompress", PidDecoder::decompress(data, size, image, plane.data()) && plane == image.pixels);
+    if (!image.invert)
+    {
+        ScratchArena::Scope scratch;
+        PidScanlineDecoder rows(data, size, image);
+        bool same = true;
+        for (int y = 0; y < image.height && same; ++y)
+        {
+            const unsigned char *row = rows.row(y);
+            same = row && std::memcmp(row, &image.pixels[static_cast<std::size_t>(y) * image.width], image.width) == 0;
+        }
+        check("scanline-decode", same);
+    }
+    {
+        // At least two workers, so large cases take the banded path even on one core
+        std::vector<unsigned char> banded(pixels);
+        const unsigned workers = (std::max)(ResolveWorkers(0), 2u);
+        check("decompress_parallel", PidDecoder::decompress_parallel(data, size, image, banded.data(), workers) && banded == image.pixels);
+    }
+    static const struct { PidRlePacking packing; const char *name; } packings[] = {
+        { PidRlePacking::Greedy, "PidEncoder-greedy" }, { PidRlePacking::Optimal, "PidEncoder-optimal" }
+    };
+    for (const auto &pack : packings)
+    {
+        std::vector<unsigned char> bytes;
+        PidImage back;
+        check(pack.name, PidEncoder::encode(image, pack.packing, bytes) &&
+                         PidDecoder::decode(bytes.data(), bytes.size(), back) &&
+                         back.width == image.width && back.height == image.height && back.pixels == image.pixels);
+    }
+
+    // --- Encode stages (MB/s of output) ---
+    const std::shared_ptr<const PaletteArtifacts> palette =
+        PaletteCache::instance().intern(image.palette, image.useTransparency);
+    MockHostStream out;
+    auto encoded = [&out](int res) -> std::size_t { return res == 0 ? out.size() : 0; };
+
+    // Balanced must never come out larger than Fast (filter 0, level 1)
+    static const struct { PNGMode mode; const char *name; } balancedChecks[] = {
+        { PNGMode::PNG_8, "SaveToPNG-8-balanced" }, { PNGMode::PNG_24, "SaveToPNG-24-balanced" },
+        { PNGMode::PNG_32, "SaveToPNG-32-balanced" }
+    };
+    for (const auto &png : balancedChecks)
+    {
+        ConvertOptions options;
+        options.pngMode = png.mode;
+        options.pngCompression = PNGCompression::Fast;
+        out.rewind();
+        const std::size_t fast = encoded(SaveToPNG(out, plane.data(), image.width, image.height, *palette, options));
+        options.pngCompression = PNGCompression::Balanced;
+        out.rewind();
+        const std::size_t balanced = encoded(SaveToPNG(out, plane.data(), image.width, image.height, *palette, options));
+        check(png.name, fast > 0 && balanced > 0 && balanced <= fast, "larger than fast");
+    }
+
+    stage("SaveToBMP", [&]() -> std::size_t {
+        out.rewind();
+        return encoded(SaveToBMP(out, plane.data(), image.width, image.height, *palette));
+    }, &out);
+    stage("SaveToTGA", [&]() -> std::size_t {
+        out.rewind();
+        return encoded(SaveToTGA(out, plane.data(), image.width, image.height, *palette));
+    }, &out);
+    stage("SaveToTGARLE", [&]() -> std::size_t {
+        out.rewind();
+        return encoded(SaveToTGARLE(out, plane.data(), image.width, image.height, *palette));
+    }, &out);
+    stage("SaveToRAW8", [&]() -> std::size_t {
+        out.rewind();
+        return encoded(SaveToRAW8(out, plane.data(), image.header, *palette));
+    }, &out);
+
+    static const struct { PNGMode mode; PNGCompression preset; const char *name; } pngStages[] = {
+        { PNGMode::PNG_8,  PNGCompression::Fast,     "SaveToPNG-8-fast" },
+        { PNGMode::PNG_8,  PNGCompression::Balanced, "SaveToPNG-8-balanced" },
+        { PNGMode::PNG_8,  PNGCompression::Smallest, "SaveToPNG-8-smallest" },
+        { PNGMode::PNG_24, PNGCompression::Fast,     "SaveToPNG-24-fast" },
+        { PNGMode::PNG_24, PNGCompression::Balanced, "SaveToPNG-24-balanced" },
+        { PNGMode::PNG_24, PNGCompression::Smallest, "SaveToPNG-24-smallest" },
+        { PNGMode::PNG_32, PNGCompression::Fast,     "SaveToPNG-32-fast" },
+        { PNGMode::PNG_32, PNGCompression::Balanced, "SaveToPNG-32-balanced" },
+        { PNGMode::PNG_32, PNGCompression::Smallest, "SaveToPNG-32-smallest" },
+    };
+    for (const auto &png : pngStages)
+    {
+        ConvertOptions options;
+        options.pngMode = png.mode;
+        options.pngCompression = png.preset;
+        stage(png.name, [&]() -> std::size_t {
+            out.rewind();
+            return encoded(SaveToPNG(out, plane.data(), image.width, image.height, *palette, options));
+        }, &out);
+    }
+
+    // --- Whole conversion as ConvertPID runs it after buffering the input
+    //     (allocations here are the per-file figure) ---
+    static const char *const convertStages[][2] = {
+        { "BMP", "ConvertPidData-BMP" }, { "TGA8RLE", "ConvertPidData-TGA8RLE" }, { "PNG", "ConvertPidData-PNG" },
+        { "RAW8", "ConvertPidData-RAW8" }
+    };
+    for (const auto &convert : convertStages)
+    {
+        const ConvertOptions options;
+        stage(convert[1], [&]() -> std::size_t {
+            out.rewind();
+            return encoded(ConvertPidData(out, data, size, convert[0], options));
+        }, &out);
+    }
+
+    // --- Back to .PID (the decoded image re-packed, MB/s of .PID output) ---
+    std::vector<unsigned char> repacked;
+    repacked.reserve(PidDecoder::max_entry_size(image));
+    stage("PidEncoder-greedy", [&]() -> std::size_t {
+        return PidEncoder::encode(image, PidRlePacking::Greedy, repacked) ? repacked.size() : 0;
+    });
+    stage("PidEncoder-optimal", [&]() -> std::size_t {
+        return PidEncoder::encode(image, PidRlePacking::Optimal, repacked) ? repacked.size() : 0;
+    });
+    return failures;
+}
+
+
+// ===================================================================
+// Entry point
+// ===================================================================
+static void PrintUsage()
+{
+    std::fprintf(stderr,
+                 PLUGIN_NAME " - benchmark v" PLUGIN_VERSION "\n"
+                 "Usage: PID_Convert_Bench [options]\n"
+                 "      --corpus <dir>           also benchmark every *.pid below dir\n"
+                 "      --no-synthetic           skip the built-in synthetic corpus\n"
+                 "      --filter <text>          run only stages whose case/stage name contains text\n"
+                 "      --min-time <ms>          minimum time per stage (default 200)\n"
+                 "      --csv                    comma-separated output\n");
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions opt;
+    bool synthetic = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * { return (i + 1 < argc) ? argv[++i] : nullptr; };
+
+        if (a == "--corpus")
+        {
+            const char *v = next(); if (!v) { PrintUsage(); return 2; }
+            opt.corpusDirs.push_back(fs::u8path(v));
+        }
+        else if (a == "--no-synthetic")
+        {
+            synthetic = false;
+        }
+        else if (a == "--filter")
+        {
+            const char *v = next(); if (!v) { PrintUsage(); return 2; }
+            opt.filter = v;
+        }
+        else if (a == "--min-time")
+        {
+            const char *v = next(); if (!v) { PrintUsage(); return 2; }
+            opt.minSeconds = std::atof(v) / 1000.0;
+        }
+        else if (a == "--csv")
+        {
+            opt.csv = true;
+        }
+        else
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    std::vector<BenchCase> corpus;
+    if (synthetic) corpus = SyntheticCorpus();
+    for (const fs::path &dir : opt.corpusDirs) AddDirectory(dir, corpus);
+    if (corpus.empty())
+    {
+        std::fprintf(stderr, "Nothing to benchmark.\n");
+        return 2;
+    }
+
+    PrintHeader(opt);
+    int failures = 0;
+    for (const BenchCase &bench : corpus) failures += RunCase(opt, bench);
+
+    const ScratchArena &arena = ScratchArena::local();
+    const DeflatePool &deflate = DeflatePool::local();
+    std::fprintf(stderr, "%zu case(s), scratch arena %zu KB in %llu block allocation(s), %llu deflateInit2 / %llu deflateReset\n",
+                 corpus.size(), arena.reserved() / 1024,
+                 static_cast<unsigned long long>(arena.block_allocations()),
+                 static_cast<unsigned long long>(deflate.inits()),
+                 static_cast<unsigned long long>(deflate.resets()));
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       atlas_packer.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Skyline rectangle packer for the batch converter's atlas mode
+ *
+ *  DETAILS:
+ *      SkylinePacker places rectangles on one fixed-size page using the
+ *      bottom-left skyline heuristic: the page top edge is kept as a list
+ *      of horizontal segments, each rectangle goes where its top ends
+ *      lowest (ties: narrowest waste, then leftmost), and the covered
+ *      segments are replaced by the rectangle's top. O(segments) per
+ *      insert, no per-pixel state, good enough for hundreds of sprites.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef ATLAS_PACKER_H
+#define ATLAS_PACKER_H
+
+#include <cstddef>
+#include <vector>
+
+
+class SkylinePacker
+{
+private:
+    struct Segment
+    {
+        int x;
+        int y;          // height of the skyline over [x, x + width)
+        int width;
+    };
+
+    int fWidth;
+    int fHeight;
+    int fUsedWidth = 0;
+    int fUsedHeight = 0;
+    std::vector<Segment> fSkyline;
+
+    // Lowest y at which a w-wide rectangle starting at segment i fits, -1 if none
+    int fit(std::size_t i, int w, int h) const
+    {
+        const int x = fSkyline[i].x;
+        if (x + w > fWidth) return -1;
+        int y = 0;
+        int left = w;
+        for (std::size_t j = i; left > 0; ++j)
+        {
+            if (j == fSkyline.size()) return -1;
+            if (fSkyline[j].y > y) y = fSkyline[j].y;
+            if (y + h > fHeight) return -1;
+            left -= fSkyline[j].width;
+        }
+        return y;
+    }
+
+    void place(std::size_t i, int x, int y, int w, int h)
+    {
+        fSkyline.insert(fSkyline.begin() + static_cast<std::ptrdiff_t>(i), Segment{ x, y + h, w });
+
+        // Trim the segments now covered by the new one
+        for (std::size_t j = i + 1; j < fSkyline.size();)
+        {
+            const int covered = fSkyline[j - 1].x + fSkyline[j - 1].width - fSkyline[j].x;
+            if (covered <= 0) break;
+            if (covered < fSkyline[j].width)
+            {
+                fSkyline[j].x += covered;
+                fSkyline[j].width -= covered;
+                break;
+            }
+            fSkyline.erase(fSkyline.begin() + static_cast<std::ptrdiff_t>(j));
+        }
+
+        // Merge neighbours of equal height
+        for (std::size_t j = 0; j + 1 < fSkyline.size();)
+        {
+            if (fSkyline[j].y == fSkyline[j + 1].y)
+            {
+                fSkyline[j].width += fSkyline[j + 1].width;
+                fSkyline.erase(fSkyline.begin() + static_cast<std::ptrdiff_t>(j + 1));
+            }
+            else
+            {
+                ++j;
+            }
+        }
+
+        if (x + w > fUsedWidth) fUsedWidth = x + w;
+        if (y + h > fUsedHeight) fUsedHeight = y + h;
+    }
+
+public:
+    SkylinePacker(int width, int height) : fWidth(width), fHeight(height)
+    {
+        fSkyline.push_back(Segment{ 0, 0, width });
+    }
+
+    // ------------------------------------------------------------------
+    // insert()
+    // ------------------------------------------------------------------
+    // Finds a place for a w x h rectangle and reserves it.
+    // - Returns: true and the top-left corner in x/y, false if the page
+    //   has no room left for it (the page is unchanged).
+    bool insert(int w, int h, int &x, int &y)
+    {
+        if (w <= 0 || h <= 0 || w > fWidth || h > fHeight) return false;
+
+        std::size_t best = fSkyline.size();
+        int bestTop = 0, bestWaste = 0;
+        for (std::size_t i = 0; i < fSkyline.size(); ++i)
+        {
+            const int top = fit(i, w, h);
+            if (top < 0) continue;
+            const int waste = fSkyline[i].width - w;   // segments always span the full page width
+            if (best == fSkyline.size() || top + h < bestTop || (top + h == bestTop && waste < bestWaste))
+            {
+                best = i;
+                bestTop = top + h;
+                bestWaste = waste;
+            }
+        }
+        if (best == fSkyline.size()) return false;
+
+        x = fSkyline[best].x;
+        y = bestTop - h;
+        place(best, x, y, w, h);
+        return true;
+    }
+
+    // Bounding box of everything placed so far (the page can be cropped to it)
+    int used_width() const { return fUsedWidth; }
+    int used_height() const { return fUsedHeight; }
+};
+
+#endif // ATLAS_PACKER_H
@@ -0,0 +1,1006 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_convert_cli.cpp
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Command-line batch converter for Gruntz .PID files
+ *
+ *  DETAILS:
+ *      Console front-end built on the same PidDecoder and SaveToBMP /
+ *      SaveToTGA / SaveToPNG code as the DU5 plugin. Takes a directory
+ *      (scanned recursively for *.pid) or a listing file of loose files
+ *      and/or entries inside .REZ archives, converts them in parallel on a
+ *      work-stealing pool sized to the core count and reports files/s and
+ *      MB/s at the end. Several formats (-f BMP,PNG) are written from one
+ *      decode per file via ExportPidData; RAW8 on its own is decoded
+ *      straight into the mapped output file. --info lists the header fields
+ *      of every entry instead (32 bytes read per file, also in parallel),
+ *      --atlas packs all of them into PNG texture pages with a JSON index.
+ *      --stats appends the ConvertStats counters (pid_stats.h).
+ *      --to-pid runs the other way: BMP / TGA / PNG / RAW8 files are read
+ *      (pid_import.h), mapped to a palette and packed into .PID files by
+ *      PidEncoder; --verify decodes every result and compares it.
+ *
+ *      Listing format (one entry per line, '#' starts a comment):
+ *          path\to\file.pid
+ *          path\to\archive.rez|<offset>|<size>|name\inside\archive.pid
+ * ============================================================================
+ */
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../PID-Convert_DU/pid_arena.h"
+#include "../PID-Convert_DU/pid_convert.h"
+#include "../PID-Convert_DU/pid_decoder.h"
+#include "../PID-Convert_DU/pid_encoders.h"
+#include "../PID-Convert_DU/pid_encoder.h"
+#include "../PID-Convert_DU/pid_import.h"
+#include "../PID-Convert_DU/memoryStream.h"
+#include "../PID-Convert_DU/mappedFile.h"
+#include "../PID-Convert_DU/pid_stats.h"
+#include "work_pool.h"
+#include "atlas_packer.h"
+
+namespace fs = std::filesystem;
+
+
+// ===================================================================
+// Batch job description
+// ===================================================================
+struct BatchJob
+{
+    fs::path source;            // loose .pid file or .rez archive
+    std::uint64_t offset = 0;   // entry offset inside the archive (0 for loose files)
+    std::uint64_t size = 0;     // entry size (0 = whole file)
+    fs::path relative;          // output path relative to the output directory
+};
+
+struct CliOptions
+{
+    fs::path input;
+    fs::path outDir;
+    std::string format = "PNG";
+    ConvertOptions convert;     // shared read-only by every job
+    unsigned jobs = 0;          // 0 = core count
+    bool info = false;          // --info: list header fields, convert nothing
+    std::string atlas;          // --atlas <name>: pack everything into <name>_<n>.png + <name>.json
+    int atlasSize = 2048;       // maximum page width/height
+    int atlasPadding = 1;       // empty pixels right of and below every frame
+    bool stats = false;         // --stats: print the ConvertStats counters at the end
+
+    bool toPid = false;         // --to-pid: images back to .pid (needs -o)
+    PidImportOptions import;    // palette choice (transparency comes from convert.transparency)
+    fs::path paletteFile;       // --palette <file.pid>: fixed palette read from that file
+    PidRlePacking packing = PidRlePacking::Optimal;
+    bool rawCoding = false;     // --packing raw: raw/repeat coding instead of RLE
+    bool verify = false;        // --verify: decode every written .pid and compare
+};
+
+
+// ===================================================================
+// Helpers
+// ===================================================================
+static void PrintUsage()
+{
+    std::fprintf(stderr,
+                 PLUGIN_NAME " - batch converter v" PLUGIN_VERSION "\n"
+                 "Usage: PID_Convert_CLI <dir | @listing.txt> [options]\n"
+                 "  -f, --format <BMP|TGA8|TGA8RLE|PNG|RAW8>[,...]\n"
+                 "                                output format(s), a list decodes once\n"
+                 "                                and writes every format (default PNG)\n"
+                 "      --png-mode <8|24|32>     PNG bit depth (default 8)\n"
+                 "      --png-compression <fast|balanced|smallest>\n"
+                 "                                PNG compression preset (default balanced)\n"
+                 "      --png-bands              deflate PNGs of a megapixel or more in row\n"
+                 "                                bands on idle threads (whole image in memory)\n"
+                 "      --transparency <auto|on|off>\n"
+                 "                                index 0 transparent per file flag, always or never\n"
+                 "      --info                   print size, flags and U[] of every file\n"
+                 "                                (header only, nothing is converted)\n"
+                 "      --atlas <name>           pack all frames into <name>_<n>.png pages\n"
+                 "                                plus a <name>.json frame index (PNG only)\n"
+                 "      --atlas-size <n>         maximum page size in pixels (default 2048)\n"
+                 "      --atlas-padding <n>      pixels between frames (default 1)\n"
+                 "      --stats                  print decode/encode/deflate counters and\n"
+                 "                                time per stage at the end\n"
+                 "      --to-pid                 BMP/TGA/PNG/RAW8 files back to .pid (needs -o)\n"
+                 "      --palette <auto|default|file.pid>\n"
+                 "                                --to-pid palette: the image's own (or median\n"
+                 "                                cut), the default table, or that file's\n"
+                 "      --packing <optimal|greedy|raw>\n"
+                 "                                --to-pid pixel coding (default optimal RLE)\n"
+                 "      --verify                 --to-pid: decode every result and compare\n"
+                 "  -o, --out <dir>               output directory (default: next to input)\n"
+                 "  -j, --jobs <n>                worker threads (default: core count)\n");
+}
+
+static bool HasPidExtension(const fs::path &p)
+{
+    return _stricmp(p.extension().string().c_str(), ".pid") == 0;
+}
+
+// --to-pid sources: whatever ImportImage reads
+static bool HasImageExtension(const fs::path &p)
+{
+    const std::string ext = p.extension().string();
+    for (const char *known : { ".bmp", ".png", ".tga", ".raw" })
+        if (_stricmp(ext.c_str(), known) == 0) return true;
+    return false;
+}
+
+// Directory input: every file below dir that accept() takes, output mirrors the tree
+static void CollectDirectory(const fs::path &dir, std::vector<BatchJob> &jobs,
+                             bool (*accept)(const fs::path &) = HasPidExtension)
+{
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir, ec), end; it != end && !ec; it.increment(ec))
+    {
+        if (!it->is_regular_file(ec) || !accept(it->path())) continue;
+        BatchJob job;
+        job.source = it->path();
+        job.relative = fs::relative(it->path(), dir, ec);
+        if (ec) job.relative = it->path().filename();
+        jobs.push_back(std::move(job));
+    }
+}
+
+// Listing input: loose paths or "archive|offset|size|name" entries
+static bool CollectListing(const fs::path &listing, std::vector<BatchJob> &jobs)
+{
+    std::ifstream in(listing);
+    if (!in) return false;
+
+    const fs::path base = listing.parent_path();
+    std::string line;
+    while (std::getline(in, line))
+    {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        BatchJob job;
+        size_t p1 = line.find('|');
+        if (p1 == std::string::npos)
+        {
+            job.source = fs::u8path(line);
+            job.relative = job.source.filename();
+        }
+        else
+        {
+            size_t p2 = line.find('|', p1 + 1);
+            size_t p3 = (p2 == std::string::npos) ? std::string::npos : line.find('|', p2 + 1);
+            if (p3 == std::string::npos)
+            {
+                std::fprintf(stderr, "Skipping malformed listing line: %s\n", line.c_str());
+                continue;
+            }
+            job.source = fs::u8path(line.substr(0, p1));
+            job.offset = std::strtoull(line.c_str() + p1 + 1, nullptr, 0);
+            job.size = std::strtoull(line.c_str() + p2 + 1, nullptr, 0);
+            job.relative = fs::u8path(line.substr(p3 + 1)).relative_path();
+        }
+        if (job.source.is_relative()) job.source = base / job.source;
+        jobs.push_back(std::move(job));
+    }
+    return true;
+}
+
+static bool ParseArgs(int argc, char **argv, CliOptions &opt)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        auto next = [&]() -> const char * { return (i + 1 < argc) ? argv[++i] : nullptr; };
+
+        if (a == "-f" || a == "--format")
+        {
+            const char *v = next(); if (!v) return false;
+            opt.format = v;
+            for (auto &c : opt.format) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+        else if (a == "--png-mode")
+        {
+            const char *v = next(); if (!v) return false;
+            int m = std::atoi(v);
+            if (m == 8) opt.convert.pngMode = PNGMode::PNG_8;
+            else if (m == 24) opt.convert.pngMode = PNGMode::PNG_24;
+            else if (m == 32) opt.convert.pngMode = PNGMode::PNG_32;
+            else return false;
+        }
+        else if (a == "--png-compression")
+        {
+            const char *v = next(); if (!v) return false;
+            std::string c = v;
+            if (c == "fast") opt.convert.pngCompression = PNGCompression::Fast;
+            else if (c == "balanced") opt.convert.pngCompression = PNGCompression::Balanced;
+            else if (c == "smallest") opt.convert.pngCompression = PNGCompression::Smallest;
+            else return false;
+        }
+        else if (a == "--png-bands")
+        {
+            opt.convert.pngBands = true;
+        }
+        else if (a == "--transparency")
+        {
+            const char *v = next(); if (!v) return false;
+            std::string t = v;
+            if (t == "auto") opt.convert.transparency = TransparencyPolicy::FromFlags;
+            else if (t == "on") opt.convert.transparency = TransparencyPolicy::Always;
+            else if (t == "off") opt.convert.transparency = TransparencyPolicy::Never;
+            else return false;
+        }
+        else if (a == "-o" || a == "--out")
+        {
+            const char *v = next(); if (!v) return false;
+            opt.outDir = fs::u8path(v);
+        }
+        else if (a == "-j" || a == "--jobs")
+        {
+            const char *v = next(); if (!v) return false;
+            opt.jobs = static_cast<unsigned>(std::atoi(v));
+        }
+        else if (a == "--info")
+        {
+            opt.info = true;
+        }
+        else if (a == "--atlas")
+        {
+            const char *v = next(); if (!v || !*v) return false;
+            opt.atlas = v;
+        }
+        else if (a == "--atlas-size")
+        {
+            const char *v = next(); if (!v) return false;
+            opt.atlasSize = std::atoi(v);
+            if (opt.atlasSize <= 0) return false;
+        }
+        else if (a == "--atlas-padding")
+        {
+            const char *v = next(); if (!v) return false;
+            opt.atlasPadding = std::atoi(v);
+            if (opt.atlasPadding < 0) return false;
+        }
+        else if (a == "--stats")
+        {
+            opt.stats = true;
+        }
+        else if (a == "--to-pid")
+        {
+            opt.toPid = true;
+        }
+        else if (a == "--palette")
+        {
+            const char *v = next(); if (!v || !*v) return false;
+            std::string p = v;
+            if (p == "auto") opt.import.choice = PidPaletteChoice::Auto;
+            else if (p == "default") opt.import.choice = PidPaletteChoice::Default;
+            else
+            {
+                opt.import.choice = PidPaletteChoice::Fixed;
+                opt.paletteFile = fs::u8path(p);
+            }
+        }
+        else if (a == "--packing")
+        {
+            const char *v = next(); if (!v) return false;
+            std::string p = v;
+            opt.rawCoding = (p == "raw");
+            if (p == "optimal") opt.packing = PidRlePacking::Optimal;
+            else if (p == "greedy") opt.packing = PidRlePacking::Greedy;
+            else if (p != "raw") return false;
+        }
+        else if (a == "--verify")
+        {
+            opt.verify = true;
+        }
+        else if (a == "-h" || a == "--help")
+        {
+            return false;
+        }
+        else if (opt.input.empty())
+        {
+            opt.input = fs::u8path(a);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return !opt.input.empty();
+}
+
+
+// ===================================================================
+// --info: header fields of every job, nothing decoded
+// - Only the 32-byte PIDHeader of each entry is touched (one page of the
+//   mapping), lines are collected per job and printed in listing order.
+// ===================================================================
+static int RunInfo(const std::vector<BatchJob> &jobs, const std::vector<std::unique_ptr<MappedFile>> &files,
+                   const std::vector<std::size_t> &fileOfJob, unsigned threads)
+{
+    std::vector<std::string> lines(jobs.size());
+    std::atomic<std::size_t> failed{ 0 };
+
+    WorkStealingPool pool(threads);
+    auto t0 = std::chrono::steady_clock::now();
+
+    pool.run(jobs.size(), [&](std::size_t index, unsigned) {
+        const BatchJob &job = jobs[index];
+        const MappedFile &file = *files[fileOfJob[index]];
+        const char *error = nullptr;
+        PidInfo info;
+
+        if (!file.data()) error = "cannot open source";
+        else if (job.offset > file.size() || job.size > file.size() - job.offset) error = "entry outside archive";
+        else
+        {
+            const std::size_t size = job.size ? static_cast<std::size_t>(job.size)
+                                              : file.size() - static_cast<std::size_t>(job.offset);
+            if (!PidDecoder::parse_header(file.data() + job.offset, size, info) ||
+                !PidDecoder::probe(info.header, size)) error = "not a .PID";
+            else
+            {
+                char attrs[6] = {
+                    info.useTransparency ? 'T' : '-', info.mirror ? 'M' : '-', info.invert ? 'I' : '-',
+                    info.rleCompression ? 'R' : '-', info.hasPalette ? 'P' : '-', 0 };
+                char buf[160];
+                std::snprintf(buf, sizeof(buf), "%d\t%d\t0x%02X\t%s\t%d\t%d\t%d\t%d\t%zu",
+                              info.width, info.height, info.header.Flags, attrs,
+                              info.header.U[0], info.header.U[1], info.header.U[2], info.header.U[3], size);
+                lines[index] = job.relative.u8string() + "\t" + buf;
+            }
+        }
+
+        if (error)
+        {
+            ++failed;
+            std::fprintf(stderr, "FAILED %s (%s)\n", job.relative.u8string().c_str(), error);
+        }
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (seconds <= 0.0) seconds = 1e-9;
+
+    std::printf("# name\twidth\theight\tflags\tTMIRP\tu0\tu1\tu2\tu3\tsize\n");
+    for (const std::string &line : lines)
+        if (!line.empty()) std::printf("%s\n", line.c_str());
+
+    // Report on stderr, so stdout stays a clean table
+    std::fprintf(stderr, "Probed %zu file(s), %zu failed, %u thread(s), %.3f s (%.2f us/file)\n",
+                 jobs.size() - failed.load(), failed.load(), pool.size(), seconds,
+                 seconds * 1e6 / static_cast<double>(jobs.size()));
+    return failed.load() ? 1 : 0;
+}
+
+
+// ===================================================================
+// --atlas: every job packed into PNG texture pages plus a JSON index
+// - Frames are decoded in parallel, then grouped by palette and
+//   transparency, since a page is one 8bpp index plane with one palette.
+// - Each group is packed largest-first with SkylinePacker (first page
+//   with room wins, a frame larger than a page gets a page of its own),
+//   pages are cropped to their content and encoded in parallel.
+// - The index lists every frame in listing order with its page, rect and
+//   the PIDHeader offsets, so a loader can position the sprite as the
+//   game does: offsetX/offsetY = U[0]/U[1], all four in "u".
+// ===================================================================
+static std::string JsonString(const std::string &text)
+{
+    std::string out = "\"";
+    for (unsigned char c : text)
+    {
+        if (c == '"' || c == '\\') { out += '\\'; out += static_cast<char>(c); }
+        else if (c < 0x20) { char buf[8]; std::snprintf(buf, sizeof(buf), "\\u%04x", c); out += buf; }
+        else out += static_cast<char>(c);
+    }
+    return out + "\"";
+}
+
+static int RunAtlas(const CliOptions &opt, const std::vector<BatchJob> &jobs,
+                    const std::vector<std::unique_ptr<MappedFile>> &files, const std::vector<std::size_t> &fileOfJob)
+{
+    struct Placement { int page = -1; int x = 0; int y = 0; };
+    struct Page { std::size_t first; int width = 0; int height = 0; std::vector<std::size_t> frames; };
+
+    std::vector<PidImage> images(jobs.size());
+    std::vector<char> decoded(jobs.size(), 0);
+    std::atomic<std::size_t> failed{ 0 };
+
+    WorkStealingPool pool(opt.jobs);
+    const unsigned workers = jobs.size() < pool.size() ? opt.convert.workers : 1;
+    auto t0 = std::chrono::steady_clock::now();
+
+    // --- Decode every frame ---
+    pool.run(jobs.size(), [&](std::size_t index, unsigned) {
+        const BatchJob &job = jobs[index];
+        const MappedFile &file = *files[fileOfJob[index]];
+        const char *error = nullptr;
+        try
+        {
+            if (!file.data()) error = "cannot open source";
+            else if (job.offset > file.size() || job.size > file.size() - job.offset) error = "entry outside archive";
+            else
+            {
+                const std::size_t size = job.size ? static_cast<std::size_t>(job.size)
+                                                  : file.size() - static_cast<std::size_t>(job.offset);
+                if (!PidDecoder::decode(file.data() + job.offset, size, images[index], workers)) error = "decode failed";
+            }
+        }
+        catch (...)
+        {
+            error = "exception";
+        }
+        ConvertStats::instance().conversion(!error);
+        if (error)
+        {
+            ++failed;
+            std::fprintf(stderr, "FAILED %s (%s)\n", job.relative.u8string().c_str(), error);
+        }
+        else
+        {
+            decoded[index] = 1;
+        }
+    });
+
+    // --- Group by palette + transparency ---
+    std::vector<std::vector<std::size_t>> groups;
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        if (!decoded[i]) continue;
+        auto same = [&](const std::vector<std::size_t> &g) {
+            const PidImage &a = images[g[0]], &b = images[i];
+            return a.useTransparency == b.useTransparency && std::memcmp(a.palette, b.palette, sizeof(a.palette)) == 0;
+        };
+        auto found = std::find_if(groups.begin(), groups.end(), same);
+        if (found == groups.end()) groups.push_back({ i });
+        else found->push_back(i);
+    }
+
+    // --- Pack: largest first, first page of the group with room ---
+    const int pad = opt.atlasPadding;
+    std::vector<Placement> placed(jobs.size());
+    std::vector<Page> pages;
+    for (std::vector<std::size_t> &group : groups)
+    {
+        std::stable_sort(group.begin(), group.end(), [&](std::size_t a, std::size_t b) {
+            if (images[a].height != images[b].height) return images[a].height > images[b].height;
+            return images[a].width > images[b].width;
+        });
+
+        std::vector<SkylinePacker> packers;
+        const std::size_t firstPage = pages.size();
+        for (std::size_t frame : group)
+        {
+            const int w = images[frame].width + pad, h = images[frame].height + pad;
+            Placement &p = placed[frame];
+            for (std::size_t k = 0; k < packers.size() && p.page < 0; ++k)
+                if (packers[k].insert(w, h, p.x, p.y)) p.page = static_cast<int>(firstPage + k);
+            if (p.page < 0)
+            {
+                packers.emplace_back((std::max)(opt.atlasSize, w), (std::max)(opt.atlasSize, h));
+                pages.push_back(Page{ frame });
+                packers.back().insert(w, h, p.x, p.y);
+                p.page = static_cast<int>(pages.size() - 1);
+            }
+            pages[static_cast<std::size_t>(p.page)].frames.push_back(frame);
+        }
+        for (std::size_t k = 0; k < packers.size(); ++k)
+        {
+            pages[firstPage + k].width = (std::max)(1, packers[k].used_width() - pad);
+            pages[firstPage + k].height = (std::max)(1, packers[k].used_height() - pad);
+        }
+    }
+
+    // --- Compose and encode the pages ---
+    std::error_code ec;
+    fs::create_directories(opt.outDir, ec);
+    std::atomic<std::size_t> pagesFailed{ 0 };
+    std::atomic<std::uint64_t> bytesOut{ 0 };
+    auto pageName = [&](std::size_t n) { return opt.atlas + "_" + std::to_string(n) + ".png"; };
+
+    // Pages split their deflate only while the pool has idle workers, like frame decode
+    ConvertOptions pageOptions = opt.convert;
+    pageOptions.workers = pages.size() < pool.size() ? opt.convert.workers : 1;
+
+    pool.run(pages.size(), [&](std::size_t n, unsigned) {
+        const Page &page = pages[n];
+        const PidImage &look = images[page.first];
+        try
+        {
+            ScratchArena::Scope scratch;
+            unsigned char *pixels = scratch.arena().alloc_array<unsigned char>(
+                static_cast<std::size_t>(page.width) * static_cast<std::size_t>(page.height), true);
+            for (std::size_t frame : page.frames)
+            {
+                const PidImage &image = images[frame];
+                const Placement &p = placed[frame];
+                for (int y = 0; y < image.height; ++y)
+                    std::memcpy(pixels + static_cast<std::size_t>(p.y + y) * page.width + p.x,
+                                &image.pixels[static_cast<std::size_t>(y) * image.width], static_cast<std::size_t>(image.width));
+            }
+
+            MemoryStream out(EstimateOutputSize(look, "PNG", opt.convert));
+            const std::shared_ptr<const PaletteArtifacts> palette =
+                PaletteCache::instance().intern(look.palette, ResolveTransparency(opt.convert, look.useTransparency));
+            const fs::path target = opt.outDir / fs::u8path(pageName(n));
+            if (SaveToPNG(out, pixels, page.width, page.height, *palette, pageOptions) != 0 ||
+                !WriteWholeFile(target.c_str(), out.data().data(), out.data().size()))
+            {
+                ++pagesFailed;
+                std::fprintf(stderr, "FAILED page %s\n", target.u8string().c_str());
+            }
+            else
+            {
+                bytesOut += out.data().size();
+            }
+        }
+        catch (...)
+        {
+            ++pagesFailed;
+            std::fprintf(stderr, "FAILED page %zu (exception)\n", n);
+        }
+    });
+
+    // --- Frame index ---
+    std::string json = "{\n  \"pages\": [";
+    for (std::size_t n = 0; n < pages.size(); ++n)
+    {
+        json += (n ? ",\n    " : "\n    ");
+        json += "{ \"file\": " + JsonString(pageName(n)) + ", \"width\": " + std::to_string(pages[n].width) +
+                ", \"height\": " + std::to_string(pages[n].height) + " }";
+    }
+    json += "\n  ],\n  \"frames\": [";
+    bool firstFrame = true;
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        if (!decoded[i]) continue;
+        const PIDHeader &h = images[i].header;
+        char buf[256];
+        std::snprintf(buf, sizeof(buf),
+                      ", \"page\": %d, \"x\": %d, \"y\": %d, \"w\": %d, \"h\": %d, "
+                      "\"offsetX\": %d, \"offsetY\": %d, \"u\": [%d, %d, %d, %d], \"flags\": %d }",
+                      placed[i].page, placed[i].x, placed[i].y, images[i].width, images[i].height,
+                      h.U[0], h.U[1], h.U[0], h.U[1], h.U[2], h.U[3], h.Flags);
+        json += (firstFrame ? "\n    " : ",\n    ");
+        json += "{ \"name\": " + JsonString(jobs[i].relative.generic_u8string()) + buf;
+        firstFrame = false;
+    }
+    json += "\n  ]\n}\n";
+
+    const fs::path index = opt.outDir / fs::u8path(opt.atlas + ".json");
+    const bool indexOk = WriteWholeFile(index.c_str(), json.data(), json.size());
+    if (!indexOk) std::fprintf(stderr, "Cannot write %s\n", index.u8string().c_str());
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (seconds <= 0.0) seconds = 1e-9;
+    std::printf("Packed %zu frame(s) into %zu page(s), %zu failed, %u thread(s), %.3f s\n",
+                jobs.size() - failed.load(), pages.size(), failed.load(), pool.size(), seconds);
+    std::printf("  %.2f MB out\n", bytesOut.load() / (1024.0 * 1024.0));
+
+    return (failed.load() || pagesFailed.load() || !indexOk) ? 1 : 0;
+}
+
+
+// ===================================================================
+// RAW8 straight into the output file
+// - The output is mapped at its final size, header and palette are put
+//   in front and the index plane is decompressed directly behind them,
+//   so the file is written without any intermediate buffer or copy.
+// - Returns nullptr on success, the error text otherwise (the partial
+//   file is deleted).
+// ===================================================================
+static const char *WriteRawMapped(const unsigned char *data, std::size_t size, const fs::path &target,
+                                  const ConvertOptions &options, std::uint64_t &written)
+{
+    PidImage image;
+    if (!PidDecoder::parse_header(data, size, image) || !PidDecoder::load_palette(data, size, image)) return "conversion failed";
+    const std::shared_ptr<const PaletteArtifacts> palette =
+        PaletteCache::instance().intern(image.palette, ResolveTransparency(options, image.useTransparency));
+
+    const std::size_t pixels = static_cast<std::size_t>(image.width) * static_cast<std::size_t>(image.height);
+    MappedOutputFile output;
+    if (!output.create(target.c_str(), RawIndexHeadSize + pixels)) return "write failed";
+    BuildRawIndexHead(output.data(), image.header, *palette);
+    if (!PidDecoder::decompress_parallel(data, size, image, output.data() + RawIndexHeadSize, options.workers))
+    {
+        output.discard();
+        return "conversion failed";
+    }
+    if (!output.close()) return "write failed";
+    ConvertStats::instance().encoded(pixels, RawIndexHeadSize + pixels);
+    written = RawIndexHeadSize + pixels;
+    return nullptr;
+}
+
+// ===================================================================
+// --to-pid: BMP / TGA / PNG / RAW8 back to .PID
+// - Each job is read with ImportImage, mapped to its palette by
+//   BuildPidImage and packed by PidEncoder::encode into <name>.pid.
+// - --verify decodes the encoded bytes again and requires the same size,
+//   header flags, U values, index plane and palette colors before
+//   anything is written.
+// ===================================================================
+static bool VerifyPid(const std::vector<unsigned char> &bytes, const PidImage &expected)
+{
+    PidImage decoded;
+    if (!PidDecoder::decode(bytes.data(), bytes.size(), decoded)) return false;
+    if (decoded.width != expected.width || decoded.height != expected.height ||
+        decoded.useTransparency != expected.useTransparency || decoded.mirror != expected.mirror ||
+        decoded.invert != expected.invert || decoded.rleCompression != expected.rleCompression ||
+        decoded.hasPalette != expected.hasPalette || decoded.header.Flags != expected.header.Flags ||
+        std::memcmp(decoded.header.U, expected.header.U, sizeof(expected.header.U)) != 0 ||
+        decoded.pixels != expected.pixels) return false;
+    for (int i = 0; i < 256; ++i)
+    {
+        const Color &a = decoded.palette[i], &b = expected.palette[i];
+        if (a.r != b.r || a.g != b.g || a.b != b.b) return false;
+    }
+    return true;
+}
+
+static int RunEncode(const CliOptions &opt, const std::vector<BatchJob> &jobs,
+                     const std::vector<std::unique_ptr<MappedFile>> &files, const std::vector<std::size_t> &fileOfJob)
+{
+    std::atomic<std::size_t> encoded{ 0 }, failed{ 0 };
+    std::atomic<std::uint64_t> bytesIn{ 0 }, bytesOut{ 0 };
+    PidImportOptions import = opt.import;
+    import.transparency = opt.convert.transparency;
+
+    WorkStealingPool pool(opt.jobs);
+    auto t0 = std::chrono::steady_clock::now();
+
+    pool.run(jobs.size(), [&](std::size_t index, unsigned) {
+        const BatchJob &job = jobs[index];
+        const MappedFile &file = *files[fileOfJob[index]];
+        const char *error = nullptr;
+
+        try
+        {
+            std::size_t size = 0;
+            ImportedImage source;
+            PidImage image;
+            std::vector<unsigned char> bytes;
+
+            if (!file.data()) error = "cannot open source";
+            else if (job.offset > file.size() || job.size > file.size() - job.offset) error = "entry outside archive";
+            else
+            {
+                const unsigned char *data = file.data() + job.offset;
+                size = job.size ? static_cast<std::size_t>(job.size)
+                                : file.size() - static_cast<std::size_t>(job.offset);
+                if (!ImportImage(data, size, source)) error = "unsupported image";
+                else if (!BuildPidImage(source, import, image)) error = "conversion failed";
+                else
+                {
+                    if (opt.rawCoding) image.rleCompression = false;
+                    if (!PidEncoder::encode(image, opt.packing, bytes)) error = "conversion failed";
+                    else if (opt.verify && !VerifyPid(bytes, image)) error = "verification failed";
+                }
+            }
+
+            if (!error)
+            {
+                fs::path target = opt.outDir / job.relative;
+                target.replace_extension(".pid");
+                std::error_code ec;
+                fs::create_directories(target.parent_path(), ec);
+                if (!WriteWholeFile(target.c_str(), bytes.data(), bytes.size())) error = "write failed";
+                else
+                {
+                    bytesIn += size;
+                    bytesOut += bytes.size();
+                }
+            }
+        }
+        catch (...)
+        {
+            error = "exception";
+        }
+
+        ConvertStats::instance().conversion(!error);
+        if (error)
+        {
+            ++failed;
+            std::fprintf(stderr, "FAILED %s (%s)\n", job.relative.u8string().c_str(), error);
+        }
+        else
+        {
+            ++encoded;
+        }
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (seconds <= 0.0) seconds = 1e-9;
+    std::printf("Encoded %zu file(s), %zu failed, %u thread(s), %.3f s%s\n",
+                encoded.load(), failed.load(), pool.size(), seconds, opt.verify ? ", verified" : "");
+    std::printf("  %.1f files/s, %.2f MB/s in (%.2f MB), %.2f MB out\n",
+                encoded.load() / seconds,
+                bytesIn.load() / seconds / (1024.0 * 1024.0), bytesIn.load() / (1024.0 * 1024.0),
+                bytesOut.load() / (1024.0 * 1024.0));
+    return failed.load() ? 1 : 0;
+}
+
+// Palette for --palette <file.pid>: embedded table or the default one
+static bool LoadPaletteFile(const fs::path &path, Color palette[256])
+{
+    MappedFile file;
+    PidImage image;
+    if (!file.open(path.c_str()) || !PidDecoder::parse_header(file.data(), file.size(), image) ||
+        !PidDecoder::load_palette(file.data(), file.size(), image)) return false;
+    std::memcpy(palette, image.palette, sizeof(image.palette));
+    return true;
+}
+
+// Several sources with one stem (a.png, a.bmp) would all write a.pid
+static void DropDuplicateTargets(std::vector<BatchJob> &jobs)
+{
+    std::map<fs::path, std::size_t> seen;
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        fs::path target = jobs[i].relative;
+        target.replace_extension(".pid");
+        if (!seen.emplace(target, i).second)
+        {
+            std::fprintf(stderr, "Skipping %s (another source writes %s)\n",
+                         jobs[i].relative.u8string().c_str(), target.u8string().c_str());
+            continue;
+        }
+        if (kept != i) jobs[kept] = std::move(jobs[i]);
+        ++kept;
+    }
+    jobs.resize(kept);
+}
+
+
+// ===================================================================
+// Entry point
+// ===================================================================
+int main(int argc, char **argv)
+{
+    CliOptions opt;
+    if (!ParseArgs(argc, argv, opt))
+    {
+        PrintUsage();
+        return 2;
+    }
+    std::vector<std::string> formats = SplitFormatList(opt.format);
+    if (formats.empty())
+    {
+        std::fprintf(stderr, "No output format given.\n");
+        return 2;
+    }
+    Color fixedPalette[256];
+    if (opt.toPid)
+    {
+        // Writing next to the inputs would overwrite the .pid files they came from
+        if (opt.outDir.empty())
+        {
+            std::fprintf(stderr, "--to-pid needs an output directory (-o).\n");
+            return 2;
+        }
+        if (!opt.paletteFile.empty())
+        {
+            if (!LoadPaletteFile(opt.paletteFile, fixedPalette))
+            {
+                std::fprintf(stderr, "Cannot read palette: %s\n", opt.paletteFile.u8string().c_str());
+                return 1;
+            }
+            opt.import.palette = fixedPalette;
+        }
+        formats.clear();
+    }
+    for (const std::string &format : formats)
+    {
+        if (!FormatExtension(format.c_str()))
+        {
+            std::fprintf(stderr, "Unsupported format: %s\n", format.c_str());
+            return 2;
+        }
+    }
+
+    // --- Collect jobs ---
+    std::vector<BatchJob> jobs;
+    std::string inputStr = opt.input.u8string();
+    if (!inputStr.empty() && inputStr[0] == '@')
+    {
+        fs::path listing = fs::u8path(inputStr.substr(1));
+        if (!CollectListing(listing, jobs))
+        {
+            std::fprintf(stderr, "Cannot read listing: %s\n", listing.u8string().c_str());
+            return 1;
+        }
+        if (opt.outDir.empty()) opt.outDir = listing.parent_path();
+    }
+    else
+    {
+        std::error_code ec;
+        if (!fs::is_directory(opt.input, ec))
+        {
+            std::fprintf(stderr, "Not a directory: %s\n", inputStr.c_str());
+            return 1;
+        }
+        CollectDirectory(opt.input, jobs, opt.toPid ? HasImageExtension : HasPidExtension);
+        if (opt.outDir.empty()) opt.outDir = opt.input;
+    }
+    if (opt.toPid) DropDuplicateTargets(jobs);
+    if (jobs.empty())
+    {
+        std::fprintf(stderr, opt.toPid ? "No image files found.\n" : "No .PID files found.\n");
+        return 1;
+    }
+
+    // --- Map every source once (archives are shared by many entries) ---
+    std::vector<std::unique_ptr<MappedFile>> files;
+    std::vector<std::size_t> fileOfJob(jobs.size());
+    {
+        std::map<fs::path, std::size_t> index;
+        for (std::size_t i = 0; i < jobs.size(); ++i)
+        {
+            auto found = index.find(jobs[i].source);
+            if (found == index.end())
+            {
+                found = index.emplace(jobs[i].source, files.size()).first;
+                files.emplace_back(new MappedFile());
+                if (!files.back()->open(jobs[i].source.c_str()))
+                    std::fprintf(stderr, "Cannot open: %s\n", jobs[i].source.u8string().c_str());
+            }
+            fileOfJob[i] = found->second;
+        }
+    }
+
+    if (opt.info) return RunInfo(jobs, files, fileOfJob, opt.jobs);
+    if (opt.toPid)
+    {
+        const int res = RunEncode(opt, jobs, files, fileOfJob);
+        if (opt.stats) std::printf("%s", ConvertStats::report(ConvertStats::instance().snapshot()).c_str());
+        return res;
+    }
+    if (!opt.atlas.empty())
+    {
+        const int res = RunAtlas(opt, jobs, files, fileOfJob);
+        if (opt.stats) std::printf("%s", ConvertStats::report(ConvertStats::instance().snapshot()).c_str());
+        return res;
+    }
+
+    // --- Convert ---
+    std::atomic<std::size_t> converted{ 0 }, failed{ 0 };
+    std::atomic<std::uint64_t> bytesIn{ 0 }, bytesOut{ 0 };
+
+    WorkStealingPool pool(opt.jobs);
+    // Encoders of one file, and the bands of one large image, get their
+    // own threads only while the pool has idle workers
+    const bool concurrentEncode = jobs.size() < pool.size();
+    if (!concurrentEncode) opt.convert.workers = 1;
+    auto t0 = std::chrono::steady_clock::now();
+
+    pool.run(jobs.size(), [&](std::size_t index, unsigned) {
+        const BatchJob &job = jobs[index];
+        const MappedFile &file = *files[fileOfJob[index]];
+        const char *error = nullptr;
+
+        try
+        {
+            PidInfo image;
+            std::vector<std::unique_ptr<MemoryStream>> outputs;
+            std::size_t size = 0;
+
+            if (!file.data()) error = "cannot open source";
+            else if (job.offset > file.size() || job.size > file.size() - job.offset) error = "entry outside archive";
+            else
+            {
+                const unsigned char *data = file.data() + job.offset;
+                size = job.size ? static_cast<std::size_t>(job.size)
+                                : file.size() - static_cast<std::size_t>(job.offset);
+                if (!PidDecoder::parse_header(data, size, image)) error = "invalid header";
+                else if (formats.size() == 1 && formats[0] == "RAW8")
+                {
+                    fs::path target = opt.outDir / job.relative;
+                    target.replace_extension(ExportSuffix(formats, 0));
+                    std::error_code ec;
+                    fs::create_directories(target.parent_path(), ec);
+                    std::uint64_t written = 0;
+                    error = WriteRawMapped(data, size, target, opt.convert, written);
+                    bytesOut += written;
+                }
+                else if (formats.size() == 1)
+                {
+                    outputs.emplace_back(new MemoryStream(EstimateOutputSize(image, formats[0].c_str(), opt.convert)));
+                    if (ConvertPidData(*outputs[0], data, size, formats[0].c_str(), opt.convert) != 0) error = "conversion failed";
+                }
+                else
+                {
+                    std::vector<ExportTarget<MemoryStream>> targets(formats.size());
+                    for (std::size_t i = 0; i < formats.size(); ++i)
+                    {
+                        outputs.emplace_back(new MemoryStream(EstimateOutputSize(image, formats[i].c_str(), opt.convert)));
+                        targets[i].cnv = formats[i].c_str();
+                        targets[i].output = outputs[i].get();
+                    }
+                    if (ExportPidData(data, size, targets.data(), targets.size(), opt.convert, concurrentEncode) != 0) error = "conversion failed";
+                }
+            }
+
+            if (!error)
+            {
+                std::error_code ec;
+                fs::create_directories((opt.outDir / job.relative).parent_path(), ec);
+                for (std::size_t i = 0; i < outputs.size() && !error; ++i)
+                {
+                    fs::path target = opt.outDir / job.relative;
+                    target.replace_extension(ExportSuffix(formats, i));
+                    const std::vector<unsigned char> &bytes = outputs[i]->data();
+                    if (!WriteWholeFile(target.c_str(), bytes.data(), bytes.size())) error = "write failed";
+                    else bytesOut += bytes.size();
+                }
+                if (!error) bytesIn += size;
+            }
+        }
+        catch (...)
+        {
+            error = "exception";
+        }
+
+        ConvertStats::instance().conversion(!error);
+        if (error)
+        {
+            ++failed;
+            std::fprintf(stderr, "FAILED %s (%s)\n", job.relative.u8string().c_str(), error);
+        }
+        else
+        {
+            ++converted;
+        }
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (seconds <= 0.0) seconds = 1e-9;
+
+    // --- Report ---
+    std::printf("Converted %zu file(s), %zu failed, %u thread(s), %.3f s\n",
+                converted.load(), failed.load(), pool.size(), seconds);
+    std::printf("  %.1f files/s, %.2f MB/s in (%.2f MB), %.2f MB/s out (%.2f MB)\n",
+                converted.load() / seconds,
+                bytesIn.load() / seconds / (1024.0 * 1024.0), bytesIn.load() / (1024.0 * 1024.0),
+                bytesOut.load() / seconds / (1024.0 * 1024.0), bytesOut.load() / (1024.0 * 1024.0));
+    if (opt.stats) std::printf("%s", ConvertStats::report(ConvertStats::instance().snapshot()).c_str());
+
+    return failed.load() ? 1 : 0;
+}
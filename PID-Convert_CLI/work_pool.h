@@ -0,0 +1,129 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       work_pool.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Work-stealing thread pool for the batch converter
+ *
+ *  DETAILS:
+ *      WorkStealingPool runs a fixed set of job indices on N worker
+ *      threads (default: hardware core count). Each worker owns a deque,
+ *      takes jobs from its back and steals from the front of the other
+ *      workers' deques once its own is empty, so a few large images do not
+ *      leave the remaining cores idle.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class WorkStealingPool
+{
+private:
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<std::size_t> jobs;
+    };
+
+    unsigned fThreads;
+
+    static bool pop_own(Queue &q, std::size_t &job)
+    {
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.jobs.empty()) return false;
+        job = q.jobs.back();
+        q.jobs.pop_back();
+        return true;
+    }
+
+    static bool steal(Queue &q, std::size_t &job)
+    {
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.jobs.empty()) return false;
+        job = q.jobs.front();
+        q.jobs.pop_front();
+        return true;
+    }
+
+public:
+    explicit WorkStealingPool(unsigned threads = 0)
+        : fThreads(threads ? threads : std::thread::hardware_concurrency())
+    {
+        if (fThreads == 0) fThreads = 1;
+    }
+
+    unsigned size() const { return fThreads; }
+
+    // ------------------------------------------------------------------
+    // run()
+    // ------------------------------------------------------------------
+    // Executes fn(jobIndex, workerIndex) for every jobIndex in [0, jobCount)
+    // and returns once all of them have finished.
+    // - Notes: jobs are dealt round-robin, so neighbouring (often similar
+    //   sized) entries start on different workers. No job spawns new jobs,
+    //   so a worker may exit as soon as every queue is empty.
+    template <class Fn>
+    void run(std::size_t jobCount, Fn &&fn)
+    {
+        if (jobCount == 0) return;
+        const unsigned workers = (jobCount < fThreads) ? static_cast<unsigned>(jobCount) : fThreads;
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        queues.reserve(workers);
+        for (unsigned w = 0; w < workers; ++w) queues.emplace_back(new Queue());
+        for (std::size_t i = 0; i < jobCount; ++i) queues[i % workers]->jobs.push_back(i);
+
+        auto worker = [&](unsigned self) {
+            std::size_t job = 0;
+            for (;;)
+            {
+                bool found = pop_own(*queues[self], job);
+                for (unsigned k = 1; !found && k < workers; ++k)
+                    found = steal(*queues[(self + k) % workers], job);
+                if (!found) return;
+                fn(job, self);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (unsigned w = 1; w < workers; ++w) threads.emplace_back(worker, w);
+        worker(0);
+        for (auto &t : threads) t.join();
+    }
+};
+
+#endif // WORK_POOL_H
@@ -32,10 +32,16 @@ SOFTWARE.
  *      Defines a secure wrapper around the non-standard TStream used in
  *      Dragon UnPACKer 5. Provides VMT layout (vmt[0]=GetSize, vmt[3]=Read,
  *      vmt[5]=Seek), assembly wrappers (Call_ReadWrite, Call_Seek32,
- *      Call_GetSize) compatible with the Delphi ABI, and the
+ *      Call_GetSize, plus Call_Seek64 / Call_GetSize64 for the Int64
+ *      overloads, used once detected per stream class) compatible with
+ *      the Delphi ABI, and the
  *      DelphiTStreamWrapper class with methods read, write, seek, get_size,
  *      read_at  all with SEH protection and fBaseOffset handling for
- *      archive-contained files.
+ *      archive-contained files. DelphiTStreamReader adds a buffered input
+ *      layer on top of it, so decoders can consume bytes from memory
+ *      instead of crossing into Delphi for every single byte; its buffer
+ *      lives in the per-thread ScratchArena. Every call into the host is
+ *      counted in ConvertStats (calls and bytes).
  * ============================================================================
  */
 
@@ -47,7 +53,14 @@ SOFTWARE.
 #include <cstddef>
 #include <stdexcept>
 #include <limits>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <utility>
 #include <excpt.h>
+#include "pid_arena.h"
+#include "pid_stats.h"
 
 // ------------------------------------------------------------------ //
 // For Dragon UnPACKer 5:
@@ -57,6 +70,7 @@ SOFTWARE.
 // vmt[3] - read function
 // vmt[4] - write function
 // vmt[5] - seek function
+// vmt[6] - Int64 seek (Delphi 6+ TStream, detected at run time)
 // ------------------------------------------------------------------ //
 
 enum class TSeekOrigin : std::uint16_t
@@ -101,6 +115,43 @@ namespace DelphiABI
         }
     }
 
+    // TStream.Seek(Self, const Offset: Int64, Origin: TSeekOrigin): Int64 (Delphi 6+)
+    // Int64 arguments are never passed in registers: Offset goes on the
+    // stack (callee pops it, ret 8), Origin takes the next register (EDX),
+    // the result comes back in EDX:EAX. ESP is restored from ESI, so a
+    // slot that turns out not to pop 8 bytes cannot unbalance the stack.
+    __declspec(naked) long long __stdcall Call_Seek64(void *self, long long offset, unsigned short origin, void *fn)
+    {
+        __asm {
+            push ebx
+            push esi
+            mov esi, esp                    // arguments now start at [esi + 12]
+            mov eax, [esi + 12]             // EAX = Self
+            movzx edx, word ptr [esi + 24]  // EDX = Origin (TSeekOrigin: 0/1/2, same values as Word)
+            push dword ptr [esi + 20]       // Offset, high dword
+            push dword ptr [esi + 16]       // Offset, low dword
+            mov ebx, [esi + 28]             // EBX = fn (address of Seek(Int64) from VMT)
+            call ebx                        // EDX:EAX = new position
+            mov esp, esi
+            pop esi
+            pop ebx
+            ret 20                          // self + offset (8) + origin + fn
+        }
+    }
+
+    // TStream.GetSize(Self): Int64 (Delphi 6+; same slot as the Longint one)
+    __declspec(naked) long long __stdcall Call_GetSize64(void *self, void *fn)
+    {
+        __asm {
+            push ebx
+            mov eax, [esp + 8]    // EAX = Self
+            mov ebx, [esp + 12]   // EBX = fn (address of GetSize method from VMT)
+            call ebx              // EDX:EAX = size
+            pop ebx
+            ret 8                 // pop 2 arguments from stack (self, fn)
+        }
+    }
+
     // TStream.GetSize(Self): Longint
     __declspec(naked) int __stdcall Call_GetSize(void *self, void *fn)
     {
@@ -155,6 +206,34 @@ namespace DelphiABI
         return result;
     }
 
+    inline long long SafeSeek64(void *self, long long offset, unsigned short origin, void *fn)
+    {
+        long long result = -1;
+        __try
+        {
+            result = Call_Seek64(self, offset, origin, fn);
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER)
+        {
+            result = -1;
+        }
+        return result;
+    }
+
+    inline long long SafeGetSize64(void *self, void *fn)
+    {
+        long long result = -1;
+        __try
+        {
+            result = Call_GetSize64(self, fn);
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER)
+        {
+            result = -1;
+        }
+        return result;
+    }
+
 } // namespace DelphiABI
 
 
@@ -173,17 +252,121 @@ private:
         static constexpr unsigned int Read    = 3; // function Read(var Buffer; Count: Longint): Longint; virtual; abstract;    // TESTED OK
         static constexpr unsigned int Write   = 4; // function Write(const Buffer; Count: Longint): Longint; virtual; abstract; // TESTED OK
         static constexpr unsigned int Seek    = 5; // function Seek(Offset: Longint; Origin: Word): Longint; virtual; abstract; // TESTED OK
+        static constexpr unsigned int Seek64  = 6; // function Seek(const Offset: Int64; Origin: TSeekOrigin): Int64; virtual; // DETECTED
 
         // --- Additional methods (inherited/extended) ---
         // In Delphi 7 TStream also has non-virtual methods (e.g. CopyFrom, ReadBuffer, WriteBuffer),
         // but they are not in the VMT because they are implemented normally.
+        // Delphi 6+ declares GetSize as Int64 (result in EDX:EAX), which is
+        // only trusted once it agrees with Seek(Int64) (see probe_int64()).
+    };
+
+    // Int64 support of a stream class, found by probe_int64()
+    enum Int64Support : int
+    {
+        Int64Unknown = -1,
+        Int64None    = 0,
+        Int64Seek    = 1,   // vmt[6] is a working Seek(Int64)
+        Int64Size    = 2    // vmt[0] returns a valid Int64 as well
     };
 
     void *fStream;
     std::int64_t fBaseOffset;
+    mutable int fInt64 = Int64Unknown;
 
     void **GetVMT() const { return *(void ***)fStream; }
 
+    // ------------------------------------------------------------------
+    // probe_int64()
+    // ------------------------------------------------------------------
+    // Finds out once per stream class (VMT) whether the Int64 overloads
+    // can be used: Seek(Int64) via vmt[6] must report the same current
+    // position as Seek(Longint), a sane end position, and return to where
+    // the stream was; GetSize is used as Int64 only if it matches that end
+    // position. The calls run under SEH with ESP restored by the thunk, the
+    // stream position is put back, and anything unexpected leaves the
+    // class on the 32-bit calls (a TStream without a real Int64 override
+    // inherits one that forwards to Seek(Longint): it passes, and behaves
+    // exactly like the 32-bit path).
+    int probe_int64() const
+    {
+        if (fInt64 != Int64Unknown) return fInt64;
+
+        void **vmt = GetVMT();
+        static std::mutex lock;
+        static std::vector<std::pair<void **, int>> known;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (const auto &k : known)
+                if (k.first == vmt) return fInt64 = k.second;
+        }
+
+        int support = Int64None;
+        void *seek32 = vmt[VMT::Seek];
+        void *seek64 = vmt[VMT::Seek64];
+        if (seek32 && seek64)
+        {
+            ConvertStats::instance().host_seek();
+            const int pos32 = DelphiABI::SafeSeek32(fStream, 0, static_cast<unsigned short>(TSeekOrigin::soFromCurrent), seek32);
+            if (pos32 >= 0)
+            {
+                ConvertStats::instance().host_seek();
+                ConvertStats::instance().host_seek();
+                const long long pos64 = DelphiABI::SafeSeek64(fStream, 0, static_cast<unsigned short>(TSeekOrigin::soFromCurrent), seek64);
+                const long long end64 = (pos64 == pos32)
+                    ? DelphiABI::SafeSeek64(fStream, 0, static_cast<unsigned short>(TSeekOrigin::soFromEnd), seek64)
+                    : -1;
+                ConvertStats::instance().host_seek();
+                const long long back = DelphiABI::SafeSeek64(fStream, pos32, static_cast<unsigned short>(TSeekOrigin::soFromBeginning), seek64);
+                if (end64 >= pos32 && back == pos32)
+                {
+                    support = Int64Seek;
+                    ConvertStats::instance().host_size();
+                    if (vmt[VMT::GetSize] && DelphiABI::SafeGetSize64(fStream, vmt[VMT::GetSize]) == end64)
+                        support |= Int64Size;
+                }
+                else
+                {
+                    // Put the stream back with the call that is known to work
+                    ConvertStats::instance().host_seek();
+                    DelphiABI::SafeSeek32(fStream, pos32, static_cast<unsigned short>(TSeekOrigin::soFromBeginning), seek32);
+                }
+            }
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        known.push_back(std::make_pair(vmt, support));
+        return fInt64 = support;
+    }
+
+    // ------------------------------------------------------------------
+    // seek_raw()
+    // ------------------------------------------------------------------
+    // Single entry point for every Seek call: Seek(Int64) when the stream
+    // class supports it, otherwise Seek(Longint) for offsets that fit
+    // (anything else fails instead of being truncated).
+    // - Returns: new absolute position (>=0) or -1 on error.
+    std::int64_t seek_raw(std::int64_t offset, TSeekOrigin origin) const
+    {
+        auto vmt = GetVMT();
+        if (probe_int64() & Int64Seek)
+        {
+            ConvertStats::instance().host_seek();
+            long long res = DelphiABI::SafeSeek64(fStream, offset, static_cast<unsigned short>(origin), vmt[VMT::Seek64]);
+            // An absolute seek must land where it was asked to (guards
+            // against an override that narrows the offset)
+            if (origin == TSeekOrigin::soFromBeginning && res != offset) return -1;
+            return (res < 0) ? -1 : static_cast<std::int64_t>(res);
+        }
+
+        void *seekPtr = vmt[VMT::Seek];
+        if (!seekPtr) return -1;
+        if (offset < std::numeric_limits<int>::min() || offset > std::numeric_limits<int>::max())
+            return -1; // needs Seek(Int64), which this stream does not have
+        ConvertStats::instance().host_seek();
+        int res = DelphiABI::SafeSeek32(fStream, static_cast<int>(offset), static_cast<unsigned short>(origin), seekPtr);
+        return static_cast<std::int64_t>(res);
+    }
+
 public:
     explicit DelphiTStreamWrapper(void *streamPtr, std::int64_t initialOffset = 0)
         : fStream(streamPtr), fBaseOffset(0)
@@ -192,13 +375,8 @@ public:
 
         if (initialOffset > 0)
         {
-            auto vmt = GetVMT();
-            void *seekPtr = vmt[VMT::Seek];
-            if (!seekPtr) throw std::runtime_error("TStream.Seek function pointer is null");
-
-            int pos = DelphiABI::SafeSeek32(fStream, static_cast<int>(initialOffset),
-                                            static_cast<unsigned short>(TSeekOrigin::soFromBeginning), seekPtr);
-            if (pos < 0) throw std::runtime_error("Seek to initialOffset failed");
+            if (!GetVMT()[VMT::Seek]) throw std::runtime_error("TStream.Seek function pointer is null");
+            if (seek_raw(initialOffset, TSeekOrigin::soFromBeginning) < 0) throw std::runtime_error("Seek to initialOffset failed");
             fBaseOffset = initialOffset;
         }
     }
@@ -220,16 +398,21 @@ public:
     //   This adds semantics compared to a plain seek().
     bool set_base_offset(std::int64_t newOffset)
     {
-        auto vmt = GetVMT();
-        void *seekPtr = vmt[VMT::Seek];
-        if (!seekPtr) return false;
-        int pos = DelphiABI::SafeSeek32(fStream, static_cast<int>(newOffset),
-                                        static_cast<unsigned short>(TSeekOrigin::soFromBeginning), seekPtr);
-        if (pos < 0) return false;
+        if (seek_raw(newOffset, TSeekOrigin::soFromBeginning) < 0) return false;
         fBaseOffset = newOffset;
         return true;
     }
 
+    std::int64_t base_offset() const { return fBaseOffset; }
+
+    // ------------------------------------------------------------------
+    // supports_int64()
+    // ------------------------------------------------------------------
+    // Returns true if the host stream takes Int64 offsets (vmt[6]), i.e.
+    // positions past 2 GB can be reached. Probes the stream class on the
+    // first call (see probe_int64()).
+    bool supports_int64() const { return (probe_int64() & Int64Seek) != 0; }
+
     // ------------------------------------------------------------------
     // position()
     // ------------------------------------------------------------------
@@ -240,12 +423,7 @@ public:
     //   Convenient alias for readability  use position() instead of seek(0, soFromCurrent).
     std::int64_t position() const
     {
-        auto vmt = GetVMT();
-        void *seekPtr = vmt[VMT::Seek];
-        if (!seekPtr) return -1;
-        int pos = DelphiABI::SafeSeek32(fStream, 0,
-                                        static_cast<unsigned short>(TSeekOrigin::soFromCurrent), seekPtr);
-        return static_cast<std::int64_t>(pos);
+        return seek_raw(0, TSeekOrigin::soFromCurrent);
     }
 
     // ------------------------------------------------------------------
@@ -255,11 +433,19 @@ public:
     // - Parameters: none (uses internal fStream pointer).
     // - Returns: stream size in bytes (>=0) or -1 on error.
     // - Notes: this is the native Delphi method  fast and correct, no "seek-hack" required.
+    //   Read as Int64 when probe_int64() confirmed it, as Longint otherwise.
     std::int64_t get_size()
     {
         auto vmt = GetVMT();
         void *sizePtr = vmt[VMT::GetSize];
         if (!sizePtr) return -1;
+        const bool wide = (probe_int64() & Int64Size) != 0;
+        ConvertStats::instance().host_size();
+        if (wide)
+        {
+            long long result = DelphiABI::SafeGetSize64(fStream, sizePtr);
+            return (result < 0) ? -1 : static_cast<std::int64_t>(result);
+        }
         int result = DelphiABI::SafeGetSize(fStream, sizePtr);
         return (result < 0) ? -1 : static_cast<std::int64_t>(result);
     }
@@ -287,7 +473,9 @@ public:
             : static_cast<int>(count);
 
         int result = DelphiABI::SafeReadWrite(fStream, buffer, icount, readPtr);
-        return (result < 0) ? 0 : static_cast<std::size_t>(result);
+        const std::size_t got = (result < 0) ? 0 : static_cast<std::size_t>(result);
+        ConvertStats::instance().host_read(got);
+        return got;
     }
 
     // ------------------------------------------------------------------
@@ -316,7 +504,9 @@ public:
                                          const_cast<void *>(buffer),
                                          icount,
                                          writePtr);
-        return (result < 0) ? 0 : static_cast<std::size_t>(result);
+        const std::size_t put = (result < 0) ? 0 : static_cast<std::size_t>(result);
+        ConvertStats::instance().host_write(put);
+        return put;
     }
 
     // ------------------------------------------------------------------
@@ -324,22 +514,14 @@ public:
     // ------------------------------------------------------------------
     // Calls Seek method from Delphi TStream VMT.
     // - Parameters:
-    //   offset : offset (Longint),
+    //   offset : offset (Int64 if the host supports it, Longint range otherwise),
     //   origin : reference point (soFromBeginning, soFromCurrent, soFromEnd).
     // - Returns: new position in the stream (>=0) or -1 on error.
     // - Notes: basic method to change stream position.
     std::int64_t seek(std::int64_t offset, TSeekOrigin origin)
     {
         if (!fStream) return -1;
-        auto vmt = GetVMT();
-        void *seekPtr = vmt[VMT::Seek];
-        if (!seekPtr) return -1;
-
-        int res = DelphiABI::SafeSeek32(fStream,
-                                        static_cast<int>(offset),
-                                        static_cast<unsigned short>(origin),
-                                        seekPtr);
-        return static_cast<std::int64_t>(res);
+        return seek_raw(offset, origin);
     }
 
     // ------------------------------------------------------------------
@@ -351,14 +533,7 @@ public:
     // - Notes: improves readability; no new functionality.
     bool seek_abs(std::int64_t absoluteOffset)
     {
-        auto vmt = GetVMT();
-        void *seekPtr = vmt[VMT::Seek];
-        if (!seekPtr) return false;
-        int res = DelphiABI::SafeSeek32(fStream,
-                                        static_cast<int>(absoluteOffset),
-                                        static_cast<unsigned short>(TSeekOrigin::soFromBeginning),
-                                        seekPtr);
-        return res >= 0;
+        return seek_raw(absoluteOffset, TSeekOrigin::soFromBeginning) >= 0;
     }
 
     // ------------------------------------------------------------------
@@ -375,18 +550,196 @@ public:
     //   and fBaseOffset points to the start of the embedded file.
     std::size_t read_at(std::int64_t relOffset, void *buffer, std::size_t count)
     {
-        auto vmt = GetVMT();
-        void *seekPtr = vmt[VMT::Seek];
-        if (!seekPtr) return 0;
+        if (seek_raw(fBaseOffset + relOffset, TSeekOrigin::soFromBeginning) < 0) return 0;
+        return read(buffer, count);
+    }
+};
 
-        int pos = DelphiABI::SafeSeek32(fStream,
-                                        static_cast<int>(fBaseOffset + relOffset),
-                                        static_cast<unsigned short>(TSeekOrigin::soFromBeginning),
-                                        seekPtr);
-        if (pos < 0) return 0;
 
-        return read(buffer, count);
+// ------------------------------------------------------------------ //
+// Class DelphiTStreamReader  buffered input on top of DelphiTStreamWrapper
+// ------------------------------------------------------------------ //
+// Every DelphiTStreamWrapper::read() goes through a SEH frame and a naked
+// thunk into the Delphi VMT, which is far too expensive to do per byte.
+// This reader pulls data in large chunks (or the whole remaining stream
+// at once via preload()) and serves bytes from a plain memory buffer.
+// The buffer is carved from a ScratchArena (allocated on first use), so
+// the reader must not outlive the ScratchArena::Scope it was created under.
+class DelphiTStreamReader
+{
+private:
+    static constexpr std::size_t DefaultChunkSize = 64 * 1024;
+
+    DelphiTStreamWrapper &fSrc;
+    ScratchArena &fArena;
+    unsigned char *fBuffer = nullptr;
+    std::size_t fCapacity = 0;  // bytes available at fBuffer
+    std::size_t fChunkSize;
+    std::size_t fPos;   // read cursor inside fBuffer
+    std::size_t fEnd;   // number of valid bytes in fBuffer
+    bool fEOF;          // true once the host stream has been fully consumed
+
+    // Moves the unconsumed bytes to the start of a new arena buffer
+    // (the old one is reclaimed with the arena scope)
+    void regrow(std::size_t capacity)
+    {
+        unsigned char *buffer = fArena.alloc_array<unsigned char>(capacity);
+        const std::size_t kept = fEnd - fPos;
+        if (kept) std::memcpy(buffer, fBuffer + fPos, kept);
+        fBuffer = buffer;
+        fCapacity = capacity;
+        fPos = 0;
+        fEnd = kept;
+    }
+
+    bool refill()
+    {
+        if (fEOF) return false;
+        if (!fBuffer) regrow(fChunkSize);
+        fPos = 0;
+        fEnd = fSrc.read(fBuffer, fCapacity);
+        if (fEnd == 0)
+        {
+            fEOF = true;
+            return false;
+        }
+        return true;
+    }
+
+public:
+    explicit DelphiTStreamReader(DelphiTStreamWrapper &src, std::size_t chunkSize = DefaultChunkSize,
+                                 ScratchArena &arena = ScratchArena::local())
+        : fSrc(src), fArena(arena), fChunkSize(chunkSize ? chunkSize : DefaultChunkSize), fPos(0), fEnd(0), fEOF(false)
+    {
     }
+
+    DelphiTStreamReader(const DelphiTStreamReader &) = delete;
+    DelphiTStreamReader &operator=(const DelphiTStreamReader &) = delete;
+
+    // ------------------------------------------------------------------
+    // preload()
+    // ------------------------------------------------------------------
+    // Reads everything from the current stream position to the end in as
+    // few host calls as possible (size taken from get_size()).
+    // - Parameters: none.
+    // - Returns: true if the whole remainder was buffered,
+    //            false if the size is unknown or the host returned less data
+    //            (the reader then keeps working with chunked refills).
+    // - Notes: bytes already buffered but not yet consumed are preserved.
+    bool preload()
+    {
+        std::int64_t size = fSrc.get_size();
+        std::int64_t pos = fSrc.position();
+        if (size < 0 || pos < 0 || size < pos) return false;
+
+        // (an Int64 size past the address space cannot be buffered at all)
+        if (static_cast<std::uint64_t>(size - pos) > (std::numeric_limits<std::size_t>::max)()) return false;
+        const std::size_t remaining = static_cast<std::size_t>(size - pos);
+
+        // One buffer for kept + remaining, never smaller than a chunk, so
+        // refills after a short read still have room
+        regrow((std::max)(fEnd - fPos + remaining, fChunkSize));
+
+        std::size_t got = 0;
+        while (got < remaining)
+        {
+            std::size_t n = fSrc.read(fBuffer + fEnd, remaining - got);
+            if (n == 0) break;
+            got += n;
+            fEnd += n;
+        }
+
+        const bool complete = (got == remaining);
+        fEOF = complete;
+        return complete;
+    }
+
+    // ------------------------------------------------------------------
+    // read_to_end()
+    // ------------------------------------------------------------------
+    // Buffers everything up to the end of the stream, so data()/available()
+    // expose it as one contiguous span.
+    // - Parameters: none.
+    // - Returns: true if at least one byte is buffered.
+    // - Notes: uses preload() first; if the host cannot report its size,
+    //   keeps reading until Read returns 0, doubling the buffer as needed.
+    bool read_to_end()
+    {
+        if (!preload())
+        {
+            if (fPos > 0 || !fBuffer) regrow((std::max)(fCapacity, fChunkSize));
+            for (;;)
+            {
+                if (fEnd == fCapacity) regrow(2 * fCapacity);
+                std::size_t n = fSrc.read(fBuffer + fEnd, fCapacity - fEnd);
+                if (n == 0) break;
+                fEnd += n;
+            }
+            fEOF = true;
+        }
+        return fEnd > fPos;
+    }
+
+    // ------------------------------------------------------------------
+    // read_up_to()
+    // ------------------------------------------------------------------
+    // Buffers at most limit more bytes from the current stream position,
+    // for entries inside a larger stream (e.g. the parent archive) whose
+    // end is not the end of the stream.
+    // - Parameters: limit : upper bound of the bytes to read.
+    // - Returns: true if at least one byte is buffered.
+    // - Notes: stops early at the end of the stream; data()/available()
+    //   expose the result as one contiguous span.
+    bool read_up_to(std::size_t limit)
+    {
+        regrow((std::max)(fEnd - fPos + limit, fChunkSize));
+        std::size_t got = 0;
+        while (got < limit)
+        {
+            std::size_t n = fSrc.read(fBuffer + fEnd, limit - got);
+            if (n == 0) { fEOF = true; break; }
+            got += n;
+            fEnd += n;
+        }
+        return fEnd > fPos;
+    }
+
+    // ------------------------------------------------------------------
+    // get()
+    // ------------------------------------------------------------------
+    // Returns the next byte of the stream.
+    // - Parameters: b : receives the byte.
+    // - Returns: true on success, false at end of stream / read error.
+    bool get(unsigned char &b)
+    {
+        if (fPos == fEnd && !refill()) return false;
+        b = fBuffer[fPos++];
+        return true;
+    }
+
+    // ------------------------------------------------------------------
+    // read()
+    // ------------------------------------------------------------------
+    // Copies up to count bytes into buffer, refilling from the host as needed.
+    // - Returns: number of bytes copied (less than count only at end of stream).
+    std::size_t read(void *buffer, std::size_t count)
+    {
+        unsigned char *out = static_cast<unsigned char *>(buffer);
+        std::size_t done = 0;
+        while (done < count)
+        {
+            if (fPos == fEnd && !refill()) break;
+            std::size_t n = (std::min)(count - done, fEnd - fPos);
+            std::memcpy(out + done, fBuffer + fPos, n);
+            fPos += n;
+            done += n;
+        }
+        return done;
+    }
+
+    // Contiguous view of the buffered, not yet consumed bytes.
+    const unsigned char *data() const { return fBuffer + fPos; }
+    std::size_t available() const { return fEnd - fPos; }
 };
 
 #endif // DELPHI_TSTREAM_WRAPPER_H
@@ -0,0 +1,222 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       mappedFile.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Win32 helpers for whole-file input and output
+ *
+ *  DETAILS:
+ *      MappedFile maps an existing file read-only, so the decoder sees it
+ *      as one memory span without copying. MappedOutputFile creates a file
+ *      of known size and maps it writable, so output can be produced in
+ *      place. WriteWholeFile creates/truncates
+ *      a file and writes a complete buffer with a single WriteFile call.
+ *      Used by the file-based conversion paths and the command-line tools.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <windows.h>
+#include <cstddef>
+#include <cstdint>
+
+
+class MappedFile
+{
+private:
+    HANDLE fFile = INVALID_HANDLE_VALUE;
+    HANDLE fMapping = nullptr;
+    const unsigned char *fView = nullptr;
+    std::size_t fSize = 0;
+
+    bool map()
+    {
+        if (fFile == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(fFile, &size) || size.QuadPart <= 0 ||
+            static_cast<unsigned long long>(size.QuadPart) > static_cast<unsigned long long>(SIZE_MAX))
+        {
+            close();
+            return false;
+        }
+        fMapping = CreateFileMappingW(fFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!fMapping) { close(); return false; }
+        fView = static_cast<const unsigned char *>(MapViewOfFile(fMapping, FILE_MAP_READ, 0, 0, 0));
+        if (!fView) { close(); return false; }
+        fSize = static_cast<std::size_t>(size.QuadPart);
+        return true;
+    }
+
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // ------------------------------------------------------------------
+    // open()
+    // ------------------------------------------------------------------
+    // Maps the whole file read-only.
+    // - Returns: true on success; false if the file is missing, empty or
+    //   cannot be mapped (the object is then closed).
+    bool open(const char *path)
+    {
+        close();
+        fFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        return map();
+    }
+
+    bool open(const wchar_t *path)
+    {
+        close();
+        fFile = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        return map();
+    }
+
+    void close()
+    {
+        if (fView) UnmapViewOfFile(fView);
+        if (fMapping) CloseHandle(fMapping);
+        if (fFile != INVALID_HANDLE_VALUE) CloseHandle(fFile);
+        fView = nullptr;
+        fMapping = nullptr;
+        fFile = INVALID_HANDLE_VALUE;
+        fSize = 0;
+    }
+
+    const unsigned char *data() const { return fView; }
+    std::size_t size() const { return fSize; }
+};
+
+
+// ------------------------------------------------------------------
+// Class MappedOutputFile
+// ------------------------------------------------------------------
+// Creates (or truncates) a file of a fixed size and maps it writable;
+// whatever is written to data() is in the file once close() returns.
+// discard() deletes the file instead (e.g. when decoding into it failed).
+class MappedOutputFile
+{
+private:
+    HANDLE fFile = INVALID_HANDLE_VALUE;
+    HANDLE fMapping = nullptr;
+    unsigned char *fView = nullptr;
+    std::size_t fSize = 0;
+
+public:
+    MappedOutputFile() = default;
+    ~MappedOutputFile() { close(); }
+
+    MappedOutputFile(const MappedOutputFile &) = delete;
+    MappedOutputFile &operator=(const MappedOutputFile &) = delete;
+
+    // ------------------------------------------------------------------
+    // create()
+    // ------------------------------------------------------------------
+    // - Returns: true if the file exists with size bytes and is mapped;
+    //   false otherwise (a half-created file is deleted again).
+    template <class Char>
+    bool create(const Char *path, std::size_t size)
+    {
+        close();
+        if (size == 0) return false;
+        if constexpr (sizeof(Char) == sizeof(wchar_t))
+            fFile = CreateFileW(path, GENERIC_READ | GENERIC_WRITE | DELETE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        else
+            fFile = CreateFileA(path, GENERIC_READ | GENERIC_WRITE | DELETE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fFile == INVALID_HANDLE_VALUE) return false;
+
+        const unsigned long long size64 = size;
+        fMapping = CreateFileMappingW(fFile, nullptr, PAGE_READWRITE,
+                                      static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), nullptr);
+        if (fMapping) fView = static_cast<unsigned char *>(MapViewOfFile(fMapping, FILE_MAP_WRITE, 0, 0, size));
+        if (!fView) { discard(); return false; }
+        fSize = size;
+        return true;
+    }
+
+    // Unmaps and closes. Returns false if the view could not be flushed.
+    bool close()
+    {
+        bool ok = true;
+        if (fView) ok = UnmapViewOfFile(fView) != FALSE;
+        if (fMapping) CloseHandle(fMapping);
+        if (fFile != INVALID_HANDLE_VALUE) CloseHandle(fFile);
+        fView = nullptr;
+        fMapping = nullptr;
+        fFile = INVALID_HANDLE_VALUE;
+        fSize = 0;
+        return ok;
+    }
+
+    // Closes and deletes the file
+    void discard()
+    {
+        if (fView) UnmapViewOfFile(fView);
+        fView = nullptr;
+        if (fMapping) CloseHandle(fMapping);
+        fMapping = nullptr;
+        if (fFile != INVALID_HANDLE_VALUE)
+        {
+            FILE_DISPOSITION_INFO disposition = { TRUE };
+            SetFileInformationByHandle(fFile, FileDispositionInfo, &disposition, sizeof(disposition));
+        }
+        close();
+    }
+
+    unsigned char *data() const { return fView; }
+    std::size_t size() const { return fSize; }
+};
+
+
+// ------------------------------------------------------------------
+// WriteWholeFile()
+// ------------------------------------------------------------------
+// Creates (or truncates) path and writes count bytes with one WriteFile call.
+// - Returns: true if all bytes were written.
+template <class Char>
+static bool WriteWholeFile(const Char *path, const void *data, std::size_t count)
+{
+    if (count > 0xFFFFFFFFu) return false; // single WriteFile is limited to DWORD
+    HANDLE h;
+    if constexpr (sizeof(Char) == sizeof(wchar_t))
+        h = CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    else
+        h = CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    DWORD written = 0;
+    BOOL ok = (count == 0) || WriteFile(h, data, static_cast<DWORD>(count), &written, nullptr);
+    CloseHandle(h);
+    return ok && written == static_cast<DWORD>(count);
+}
+
+#endif // MAPPED_FILE_H
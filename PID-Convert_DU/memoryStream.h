@@ -0,0 +1,115 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       memoryStream.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      In-memory stream with the DelphiTStreamWrapper interface
+ *
+ *  DETAILS:
+ *      MemoryStream is a growable byte buffer exposing the read, write,
+ *      seek_abs, position and get_size methods of DelphiTStreamWrapper,
+ *      so the encoders in pid_encoders.h can write to memory when no
+ *      Dragon UnPACKer host stream is involved. It does not pull in the
+ *      Delphi ABI thunks, so it is usable from x64 builds as well.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef MEMORY_STREAM_H
+#define MEMORY_STREAM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+
+class MemoryStream
+{
+private:
+    std::vector<unsigned char> fData;
+    std::size_t fPos = 0;
+
+public:
+    MemoryStream() = default;
+    explicit MemoryStream(std::size_t reserveBytes) { fData.reserve(reserveBytes); }
+
+    MemoryStream(const MemoryStream &) = delete;
+    MemoryStream &operator=(const MemoryStream &) = delete;
+
+    // ------------------------------------------------------------------
+    // read()
+    // ------------------------------------------------------------------
+    // Copies up to count bytes from the current position.
+    // - Returns: number of bytes copied (0 at end of stream).
+    std::size_t read(void *buffer, std::size_t count)
+    {
+        if (!buffer || fPos >= fData.size()) return 0;
+        std::size_t n = fData.size() - fPos;
+        if (count < n) n = count;
+        std::memcpy(buffer, fData.data() + fPos, n);
+        fPos += n;
+        return n;
+    }
+
+    // ------------------------------------------------------------------
+    // write()
+    // ------------------------------------------------------------------
+    // Writes count bytes at the current position, growing the buffer if needed.
+    // - Returns: number of bytes written (count, or 0 for null/empty input).
+    std::size_t write(const void *buffer, std::size_t count)
+    {
+        if (!buffer || count == 0) return 0;
+        if (fPos + count > fData.size()) fData.resize(fPos + count);
+        std::memcpy(fData.data() + fPos, buffer, count);
+        fPos += count;
+        return count;
+    }
+
+    // ------------------------------------------------------------------
+    // seek_abs()
+    // ------------------------------------------------------------------
+    // Moves to an absolute position. Seeking past the end is allowed;
+    // the gap is zero-filled on the next write.
+    // - Returns: true if absoluteOffset is not negative.
+    bool seek_abs(std::int64_t absoluteOffset)
+    {
+        if (absoluteOffset < 0) return false;
+        fPos = static_cast<std::size_t>(absoluteOffset);
+        return true;
+    }
+
+    std::int64_t position() const { return static_cast<std::int64_t>(fPos); }
+    std::int64_t get_size() const { return static_cast<std::int64_t>(fData.size()); }
+
+    void reserve(std::size_t bytes) { fData.reserve(bytes); }
+
+    // Direct access to the written bytes
+    const std::vector<unsigned char> &data() const { return fData; }
+    void clear() { fData.clear(); fPos = 0; }
+};
+
+#endif // MEMORY_STREAM_H
@@ -0,0 +1,145 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_arena.cpp
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Per-thread grow-only scratch arena for conversion buffers
+ *
+ *  DETAILS:
+ *      Implementation of ScratchArena (block list with a bump pointer,
+ *      merge-on-empty) and the thread_local instance behind local().
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "pid_arena.h"
+
+
+// ===================================================================
+// Blocks
+// ===================================================================
+ScratchArena::Block ScratchArena::new_block(std::size_t size)
+{
+    Block block;
+    block.raw = new unsigned char[size + Alignment - 1];
+    const std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(block.raw);
+    block.data = block.raw + ((Alignment - addr % Alignment) % Alignment);
+    block.size = size;
+    ++fAllocations;
+    return block;
+}
+
+ScratchArena::~ScratchArena()
+{
+    for (Block &block : fBlocks) delete[] block.raw;
+}
+
+std::size_t ScratchArena::reserved() const
+{
+    std::size_t total = 0;
+    for (const Block &block : fBlocks) total += block.size;
+    return total;
+}
+
+// ===================================================================
+// Allocation
+// ===================================================================
+void *ScratchArena::alloc(std::size_t bytes, bool zero)
+{
+    // Round up so every allocation starts on an Alignment boundary
+    bytes = (bytes + Alignment - 1) / Alignment * Alignment;
+    if (bytes == 0) bytes = Alignment;
+
+    if (fBlocks.empty())
+    {
+        fBlocks.reserve(4);
+        fBlocks.push_back(new_block((std::max)(bytes, MinBlockSize)));
+        fCurrent = 0;
+        fOffset = 0;
+    }
+
+    for (;;)
+    {
+        Block &block = fBlocks[fCurrent];
+        if (block.size - fOffset >= bytes)
+        {
+            unsigned char *p = block.data + fOffset;
+            fOffset += bytes;
+            if (zero) std::memset(p, 0, bytes);
+            return p;
+        }
+
+        // Blocks after fCurrent are free: reuse the next one if it is big
+        // enough, otherwise replace them all with one that is
+        const std::size_t next = fCurrent + 1;
+        if (next < fBlocks.size() && fBlocks[next].size >= bytes)
+        {
+            fCurrent = next;
+            fOffset = 0;
+            continue;
+        }
+        for (std::size_t i = next; i < fBlocks.size(); ++i) delete[] fBlocks[i].raw;
+        fBlocks.resize(next);
+        fBlocks.reserve(next + 1);
+
+        // Geometric growth keeps the number of blocks per file small
+        fBlocks.push_back(new_block((std::max)(bytes, (std::max)(MinBlockSize, reserved()))));
+        fCurrent = next;
+        fOffset = 0;
+    }
+}
+
+void ScratchArena::release(const Mark &m)
+{
+    fCurrent = m.block;
+    fOffset = m.offset;
+    if (fCurrent != 0 || fOffset != 0 || fBlocks.empty()) return;
+
+    // Empty again: merge so the next file of the same size fits in one block
+    const std::size_t total = reserved();
+    if (fBlocks.size() == 1 && total <= MaxRetained) return;
+    for (Block &block : fBlocks) delete[] block.raw;
+    fBlocks.clear();
+    if (total > MaxRetained) return;
+    try
+    {
+        fBlocks.push_back(new_block(total));    // capacity kept by clear(), only new can throw
+    }
+    catch (...)
+    {
+        // out of memory: stay empty, the next alloc() starts over
+    }
+}
+
+// ===================================================================
+// Per-thread instance
+// ===================================================================
+ScratchArena &ScratchArena::local()
+{
+    static thread_local ScratchArena arena;
+    return arena;
+}
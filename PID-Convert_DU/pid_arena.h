@@ -0,0 +1,144 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_arena.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Per-thread grow-only scratch arena for conversion buffers
+ *
+ *  DETAILS:
+ *      Every conversion needs the same handful of temporary buffers: the
+ *      buffered source file, the W*H index plane, decoder and PNG row
+ *      buffers, the deflate output buffer and the BMP / TGA RLE write
+ *      blocks. Instead of allocating them per file, they are carved out
+ *      of ScratchArena::local(), a bump allocator kept per thread. Blocks
+ *      are only added, never freed while in use; once the arena is empty
+ *      again they are merged into one block, so after the first few files
+ *      a conversion performs no heap allocation for scratch memory.
+ *      Memory is released in stack order through ScratchArena::Scope.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef PID_ARENA_H
+#define PID_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// =======================
+// Scratch arena
+// =======================
+// Not thread-safe by design: each thread uses its own local() arena.
+// Pointers stay valid until the Scope (or mark) they were allocated
+// under is released; blocks never move.
+class ScratchArena
+{
+public:
+    static constexpr std::size_t Alignment = 64;                    // cache line, also fine for SIMD loads
+    static constexpr std::size_t MinBlockSize = 256 * 1024;
+    static constexpr std::size_t MaxRetained = 64 * 1024 * 1024;    // larger arenas are trimmed once empty
+
+    struct Mark
+    {
+        std::size_t block;
+        std::size_t offset;
+    };
+
+    // ------------------------------------------------------------------
+    // Scope
+    // ------------------------------------------------------------------
+    // Remembers the arena position on construction and releases everything
+    // allocated after it on destruction (also when unwinding).
+    class Scope
+    {
+    public:
+        explicit Scope(ScratchArena &arena = ScratchArena::local()) : fArena(arena), fMark(arena.mark()) {}
+        ~Scope() { fArena.release(fMark); }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        ScratchArena &arena() const { return fArena; }
+
+    private:
+        ScratchArena &fArena;
+        Mark fMark;
+    };
+
+    ScratchArena() = default;
+    ~ScratchArena();
+    ScratchArena(const ScratchArena &) = delete;
+    ScratchArena &operator=(const ScratchArena &) = delete;
+
+    // ------------------------------------------------------------------
+    // alloc()
+    // ------------------------------------------------------------------
+    // Returns bytes of uninitialized, Alignment-aligned memory (zeroed
+    // when zero is set). Adds a block if the current one is too small.
+    // - Returns: never nullptr (throws std::bad_alloc like operator new).
+    void *alloc(std::size_t bytes, bool zero = false);
+
+    // Typed variant for trivially copyable element types
+    template <class T>
+    T *alloc_array(std::size_t count, bool zero = false)
+    {
+        return static_cast<T *>(alloc(count * sizeof(T), zero));
+    }
+
+    Mark mark() const { return { fCurrent, fOffset }; }
+
+    // ------------------------------------------------------------------
+    // release()
+    // ------------------------------------------------------------------
+    // Rewinds to m (everything allocated after it becomes free). When the
+    // arena becomes empty, several blocks are merged into one of their
+    // combined size (or dropped if that exceeds MaxRetained).
+    void release(const Mark &m);
+
+    std::size_t reserved() const;                                   // bytes held in blocks
+    std::uint64_t block_allocations() const { return fAllocations; } // heap allocations so far
+
+    // Arena of the calling thread
+    static ScratchArena &local();
+
+private:
+    struct Block
+    {
+        unsigned char *raw;     // as returned by operator new
+        unsigned char *data;    // raw aligned up to Alignment
+        std::size_t size;       // usable bytes from data
+    };
+
+    Block new_block(std::size_t size);      // counts the allocation
+
+    std::vector<Block> fBlocks;
+    std::size_t fCurrent = 0;   // block the next allocation comes from
+    std::size_t fOffset = 0;    // bytes used in fBlocks[fCurrent]
+    std::uint64_t fAllocations = 0;
+};
+
+#endif // PID_ARENA_H
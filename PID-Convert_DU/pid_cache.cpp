@@ -0,0 +1,217 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_cache.cpp
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Bounded LRU cache of decoded .PID images, probe verdicts
+ *
+ *  DETAILS:
+ *      Implementation of DecodeCache (list + hash map LRU under a mutex)
+ *      and ProbeCache (hash map of verdicts under a mutex).
+ * ============================================================================
+ */
+
+#include <cstring>
+#include "pid_cache.h"
+
+
+// ===================================================================
+// Key / footprint
+// ===================================================================
+// The fingerprint tells apart same-named entries of different archives
+// that share offset, size and header (e.g. animation frames)
+static std::string make_key(const DecodeCacheKey &key, bool withFingerprint = true)
+{
+    std::string k = key.name;
+    k.push_back('\0');
+    k.append(reinterpret_cast<const char *>(&key.offset), sizeof(key.offset));
+    k.append(reinterpret_cast<const char *>(&key.size), sizeof(key.size));
+    if (withFingerprint) k.append(reinterpret_cast<const char *>(&key.fingerprint), sizeof(key.fingerprint));
+    return k;
+}
+
+std::size_t DecodeCache::footprint(const PidImage &image)
+{
+    return sizeof(PidImage) + image.pixels.capacity();
+}
+
+// ===================================================================
+// Lookup / insert
+// ===================================================================
+std::shared_ptr<const PidImage> DecodeCache::find(const DecodeCacheKey &key, const PIDHeader *header,
+                                                  DecodeCacheTail *tail)
+{
+    const std::string k = make_key(key);
+    std::lock_guard<std::mutex> guard(fLock);
+    auto it = fIndex.find(k);
+    if (it == fIndex.end()) return nullptr;
+    if (header && std::memcmp(header, &it->second->image->header, sizeof(PIDHeader)) != 0)
+    {
+        // Same name/offset/size but different content: drop the stale entry
+        fUsed -= it->second->bytes;
+        fLru.erase(it->second);
+        fIndex.erase(it);
+        return nullptr;
+    }
+    fLru.splice(fLru.begin(), fLru, it->second);
+    if (tail) *tail = it->second->tail;
+    return it->second->image;
+}
+
+bool DecodeCache::insert(const DecodeCacheKey &key, std::shared_ptr<const PidImage> image,
+                         const DecodeCacheTail &tail)
+{
+    if (!image) return false;
+    const std::size_t bytes = footprint(*image);
+    const std::string k = make_key(key);
+
+    std::lock_guard<std::mutex> guard(fLock);
+    if (bytes > fCapacity) return false;
+
+    auto it = fIndex.find(k);
+    if (it != fIndex.end())
+    {
+        fUsed -= it->second->bytes;
+        fLru.erase(it->second);
+        fIndex.erase(it);
+    }
+    fLru.push_front(Entry{ k, std::move(image), bytes, tail });
+    fIndex[k] = fLru.begin();
+    fUsed += bytes;
+    evict_locked();
+    return true;
+}
+
+void DecodeCache::erase(const DecodeCacheKey &key)
+{
+    const std::string k = make_key(key);
+    std::lock_guard<std::mutex> guard(fLock);
+    auto it = fIndex.find(k);
+    if (it == fIndex.end()) return;
+    fUsed -= it->second->bytes;
+    fLru.erase(it->second);
+    fIndex.erase(it);
+}
+
+bool DecodeCache::note_miss(const DecodeCacheKey &key)
+{
+    std::string k = make_key(key);
+    std::lock_guard<std::mutex> guard(fLock);
+    for (auto it = fMisses.begin(); it != fMisses.end(); ++it)
+    {
+        if (*it != k) continue;
+        fMisses.erase(it);
+        return true;
+    }
+    fMisses.push_front(std::move(k));
+    if (fMisses.size() > MaxMisses) fMisses.pop_back();
+    return false;
+}
+
+// ===================================================================
+// Capacity
+// ===================================================================
+void DecodeCache::evict_locked()
+{
+    while (fUsed > fCapacity && !fLru.empty())
+    {
+        fUsed -= fLru.back().bytes;
+        fIndex.erase(fLru.back().key);
+        fLru.pop_back();
+    }
+}
+
+void DecodeCache::set_capacity(std::size_t capacityBytes)
+{
+    std::lock_guard<std::mutex> guard(fLock);
+    fCapacity = capacityBytes;
+    evict_locked();
+}
+
+std::size_t DecodeCache::capacity() const
+{
+    std::lock_guard<std::mutex> guard(fLock);
+    return fCapacity;
+}
+
+std::size_t DecodeCache::used() const
+{
+    std::lock_guard<std::mutex> guard(fLock);
+    return fUsed;
+}
+
+void DecodeCache::clear()
+{
+    std::lock_guard<std::mutex> guard(fLock);
+    fLru.clear();
+    fIndex.clear();
+    fMisses.clear();
+    fUsed = 0;
+}
+
+DecodeCache &DecodeCache::instance()
+{
+    static DecodeCache cache;
+    return cache;
+}
+
+// ===================================================================
+// Probe verdicts
+// ===================================================================
+ProbeCache::Verdict ProbeCache::find(const DecodeCacheKey &key) const
+{
+    const std::string k = make_key(key, false);
+    std::lock_guard<std::mutex> guard(fLock);
+    auto it = fVerdicts.find(k);
+    if (it == fVerdicts.end()) return Unknown;
+    return it->second ? IsPid : NotPid;
+}
+
+void ProbeCache::insert(const DecodeCacheKey &key, bool isPid)
+{
+    std::string k = make_key(key, false);
+    std::lock_guard<std::mutex> guard(fLock);
+    if (fVerdicts.size() >= MaxEntries && fVerdicts.find(k) == fVerdicts.end()) fVerdicts.clear();
+    fVerdicts[std::move(k)] = isPid;
+}
+
+std::size_t ProbeCache::size() const
+{
+    std::lock_guard<std::mutex> guard(fLock);
+    return fVerdicts.size();
+}
+
+void ProbeCache::clear()
+{
+    std::lock_guard<std::mutex> guard(fLock);
+    fVerdicts.clear();
+}
+
+ProbeCache &ProbeCache::instance()
+{
+    static ProbeCache cache;
+    return cache;
+}
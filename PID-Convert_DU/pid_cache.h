@@ -0,0 +1,187 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_cache.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Bounded LRU cache of decoded .PID images, probe verdicts
+ *
+ *  DETAILS:
+ *      DecodeCache keeps recently decoded PidImage objects (index plane +
+ *      palette) keyed by entry name, archive offset, entry size and a CRC
+ *      of the entry's first bytes, so a
+ *      preview followed by exports in other formats decodes only once.
+ *      Entries are shared read-only (shared_ptr<const PidImage>), the total
+ *      footprint is capped, and all methods are thread-safe. Each entry
+ *      also records where it ends and a CRC of its last bytes (end of the
+ *      pixel stream, palette trailer), which the caller checks against
+ *      the source on a hit before serving the image. An entry is
+ *      only worth a full decode once it has been asked for twice, so the
+ *      cache also remembers a short list of recent misses.
+ *      ProbeCache remembers, under the same key, whether an entry's header
+ *      passed PidDecoder::probe(), for the DUCI calls that get no stream.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef PID_CACHE_H
+#define PID_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "pid_decoder.h"
+
+
+// =======================
+// Cache key (DecodeCache and ProbeCache)
+// =======================
+struct DecodeCacheKey
+{
+    std::string name;       // entry name as passed by the host
+    std::int64_t offset;    // entry offset inside the archive
+    std::int64_t size;      // entry size in bytes
+    std::uint32_t fingerprint = 0;  // CRC-32 of the header and first pixel bytes
+                                    // (DecodeCache only: ProbeCache callers have no bytes)
+};
+
+// End of a cached entry, recorded at insert and checked on a hit: the
+// entry length and the CRC-32 of its last DecodeCache::TailBytes bytes
+struct DecodeCacheTail
+{
+    std::int64_t length = 0;
+    std::uint32_t crc = 0;
+};
+
+
+// =======================
+// LRU cache
+// =======================
+class DecodeCache
+{
+public:
+    static const std::size_t DefaultCapacity = 64u * 1024u * 1024u;   // 64 MB
+    static const std::size_t MaxMisses = 64;                          // remembered by note_miss()
+    static const std::size_t TailBytes = 1024;                        // pixel stream end + 768-byte palette
+
+    explicit DecodeCache(std::size_t capacityBytes = DefaultCapacity) : fCapacity(capacityBytes) {}
+
+    // ------------------------------------------------------------------
+    // find()
+    // ------------------------------------------------------------------
+    // Looks up key and, if header is given, checks that the cached image
+    // was decoded from a file with the same 32-byte PIDHeader. tail
+    // (optional) receives what insert() recorded, for the caller to
+    // compare with the end of its source (erase() the entry if it differs).
+    // - Returns: the cached image (marked most recently used) or nullptr.
+    std::shared_ptr<const PidImage> find(const DecodeCacheKey &key, const PIDHeader *header = nullptr,
+                                         DecodeCacheTail *tail = nullptr);
+
+    // ------------------------------------------------------------------
+    // insert()
+    // ------------------------------------------------------------------
+    // Adds or replaces key, then evicts least recently used entries until
+    // the total footprint fits the capacity.
+    // - Returns: false if the image alone is larger than the capacity
+    //   (nothing is stored).
+    bool insert(const DecodeCacheKey &key, std::shared_ptr<const PidImage> image,
+                const DecodeCacheTail &tail = DecodeCacheTail());
+
+    // Drops key if it is cached
+    void erase(const DecodeCacheKey &key);
+
+    // ------------------------------------------------------------------
+    // note_miss()
+    // ------------------------------------------------------------------
+    // Records that key missed. The first miss of an entry is converted
+    // without the cache (pipelined, scratch arena); only a repeat request
+    // decodes into it. The oldest of more than MaxMisses keys is dropped.
+    // - Returns: true if key had already missed (it is then forgotten).
+    bool note_miss(const DecodeCacheKey &key);
+
+    // Capacity in bytes; 0 disables the cache (and drops all entries)
+    void set_capacity(std::size_t capacityBytes);
+    std::size_t capacity() const;
+    std::size_t used() const;
+    void clear();
+
+    // Approximate memory held by one cached image
+    static std::size_t footprint(const PidImage &image);
+
+    // Process-wide cache used by the DUCI entry points
+    static DecodeCache &instance();
+
+private:
+    struct Entry
+    {
+        std::string key;
+        std::shared_ptr<const PidImage> image;
+        std::size_t bytes;
+        DecodeCacheTail tail;
+    };
+
+    void evict_locked();
+
+    mutable std::mutex fLock;
+    std::list<Entry> fLru;          // front = most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> fIndex;
+    std::list<std::string> fMisses; // front = most recent
+    std::size_t fCapacity;
+    std::size_t fUsed = 0;
+};
+
+
+// =======================
+// Probe verdicts
+// =======================
+// Filled where the entry's bytes are available (ConvertStream peeks the
+// header), consulted by IsFileCompatible / GetFileConvert, which only get
+// the entry name, offset and size. Bounded by entry count: when full it is
+// simply emptied, since a verdict is cheap to recompute.
+class ProbeCache
+{
+public:
+    enum Verdict { Unknown = -1, NotPid = 0, IsPid = 1 };
+
+    static const std::size_t MaxEntries = 16384;
+
+    Verdict find(const DecodeCacheKey &key) const;
+    void insert(const DecodeCacheKey &key, bool isPid);
+    std::size_t size() const;
+    void clear();
+
+    // Process-wide verdicts used by the DUCI entry points
+    static ProbeCache &instance();
+
+private:
+    mutable std::mutex fLock;
+    std::unordered_map<std::string, bool> fVerdicts;
+};
+
+#endif // PID_CACHE_H
@@ -31,11 +31,13 @@ SOFTWARE.
  *  DETAILS:
  *      Main implementation of the DUCI plugin for the .PID format (Gruntz 1999).
  *      Exports 7 DUCI functions (DUCIVersion, VersionInfo2, IsFileCompatible,
- *      GetFileConvert, ConvertStream, InitPlugin, ConfigBox, AboutBox).
- *      Handles RLE decompression, palette (default or external), flags
- *      (transparency, mirror, invert), and export to:
+ *      GetFileConvert, ConvertStream, InitPlugin, ConfigBox, AboutBox),
+ *      plus the file-based Convert used by older DUCI hosts.
+ *      Decoding (RLE, palette, mirror/invert flags) is done by PidDecoder
+ *      (pid_decoder.h) and the writers live in pid_encoders.h; this file
+ *      handles the DUCI glue and routes the host streams to export as:
  *          - BMP (24bpp BGR)
- *          - TGA (8bpp paletted)
+ *          - TGA (8bpp paletted, uncompressed or RLE)
  *          - PNG (8/24/32bpp with zlib)
  *
  *      Uses DelphiTStreamWrapper for safe I/O with SEH protection,
@@ -52,10 +54,19 @@ SOFTWARE.
 #include <zlib.h>
 #include <string>
 #include <algorithm>
+#include <memory>
+#include <mutex>
 #include <cstdio>
 #include <cstdlib>
 #include <cctype>
 #include "pid_convert.h"
+#include "pid_decoder.h"
+#include "pid_encoders.h"
+#include "memoryStream.h"
+#include "mappedFile.h"
+#include "pid_cache.h"
+#include "pid_arena.h"
+#include "pid_stats.h"
 
 
 
@@ -75,6 +86,26 @@ HWND AHandle = nullptr;
 void *AOwner = nullptr;
 char CurPath[256] = { 0 };
 
+// ===================================================================
+// Conversion settings (written by ConfigDlgProc)
+// - Each conversion copies them once under the lock before it starts,
+//   so changing them in the dialog never affects a running export.
+// ===================================================================
+static std::mutex g_settingsLock;
+static ConvertOptions g_settings;
+
+static ConvertOptions CurrentOptions()
+{
+    std::lock_guard<std::mutex> lock(g_settingsLock);
+    return g_settings;
+}
+
+static void StoreOptions(const ConvertOptions &options)
+{
+    std::lock_guard<std::mutex> lock(g_settingsLock);
+    g_settings = options;
+}
+
 // ===================================================================
 // Plugin metadata constants (from pid_convert.h)
 // ===================================================================
@@ -89,348 +120,111 @@ static const ConvertInfoRec pluginInfo = [] {
 }();
 
 // ===================================================================
-// Helper: write PNG chunk (internal linkage)
+// Probe a PID stream: metadata only (size, flags, U[4]), nothing decoded
+// - One small read from the start of src (the 32-byte header plus up to
+//   ProbeFingerprintBytes of pixel data); info (optional) receives the
+//   header fields.
+// - entry (optional) names the archive entry: its size and the CRC-32 of
+//   the bytes read (DecodeCacheKey::fingerprint) are filled from the
+//   stream and the verdict is recorded in ProbeCache for IsFileCompatible.
+// - If src is not a .PID from its start but holds more than entry->offset
+//   bytes, it may be the parent archive itself: the header is then looked
+//   for at entry->offset. On a hit *base (optional) receives that offset
+//   and entry->size is 0 (the length is measured once the data is read).
+// - Returns 0 for a .PID, 1 otherwise.
 // ===================================================================
-static void write_PNG_Chunk(std::vector<char> &buffer, const char *type, const unsigned char *data, unsigned int length)
-{
-    // Writes length (big-endian), type, data and CRC into the buffer
-    unsigned int len = _byteswap_ulong(length);
-    buffer.insert(buffer.end(), (char *)&len, (char *)&len + 4);
-    buffer.insert(buffer.end(), type, type + 4);
-    if (data && length > 0)
-    {
-        buffer.insert(buffer.end(), data, data + length);
-    }
-    unsigned int crc = crc32_png(reinterpret_cast<const unsigned char *>(type), 4);
-    if (data && length > 0)
-    {
-        crc = crc32_png(data, length, crc);
-    }
-    crc = _byteswap_ulong(crc);
-    buffer.insert(buffer.end(), (char *)&crc, (char *)&crc + 4);
-}
+static const std::size_t ProbeFingerprintBytes = 256;
 
-// ===================================================================
-// Save as BMP 24bpp (true-color, BGR)
-// - Writes fields explicitly in little-endian to avoid padding issues.
-// - Uses palette and supports transparency.
-// ===================================================================
-static int SaveToBMP(DelphiTStreamWrapper &dst,
-              const std::vector<unsigned char> &pixels,
-              int width, int height,
-              const Color *palette_src,
-              bool useTransparency)
+static int ProbePID(void *src, PidInfo *info, DecodeCacheKey *entry, std::int64_t *base)
 {
-    // Copy palette and optionally zero index 0 (transparent -> black)
-    Color palette[256];
-    std::memcpy(palette, palette_src, sizeof(palette));
-    if (useTransparency)
+    try
     {
-        palette[0].r = 0;
-        palette[0].g = 0;
-        palette[0].b = 0;
-    }
-
-    // Image parameters
-    const int bpp = 24;                            // we write 24bpp BGR (true-color)
-    const int rowSize = ((width * 3 + 3) & ~3);    // align to 4 bytes
-    const int imageSize = rowSize * height;
-    const uint32_t infoSize = 40;                  // BITMAPINFOHEADER size
-    const uint32_t paletteBytes = 0;               // no palette for 24bpp in BMP DIB
-    const uint32_t dataOffset = 14 + infoSize + static_cast<uint32_t>(paletteBytes);
-    const uint32_t fileSize = dataOffset + static_cast<uint32_t>(imageSize);
-
-    // Helper lambdas to write LE 16/32-bit
-    auto write_u16 = [&](uint16_t v) -> bool {
-        unsigned char b[2] = {
-            static_cast<unsigned char>(v & 0xFF),
-            static_cast<unsigned char>((v >> 8) & 0xFF)
-        };
-        return dst.write(b, 2) == 2;
-    };
-    auto write_u32 = [&](uint32_t v) -> bool {
-        unsigned char b[4] = {
-            static_cast<unsigned char>(v & 0xFF),
-            static_cast<unsigned char>((v >> 8) & 0xFF),
-            static_cast<unsigned char>((v >> 16) & 0xFF),
-            static_cast<unsigned char>((v >> 24) & 0xFF)
+        ConvertStats::Timer timer(ConvertStats::StageRead);
+        DelphiTStreamWrapper srcStream(src);
+        const std::int64_t size = srcStream.get_size();
+        if (entry) entry->size = size;
+        if (base) *base = 0;
+
+        unsigned char buffer[sizeof(PIDHeader) + ProbeFingerprintBytes];
+        std::size_t got = 0;
+        auto readHead = [&](std::int64_t at) {
+            got = srcStream.seek_abs(at) ? srcStream.read(buffer, sizeof(buffer)) : 0;
+            return got >= sizeof(PIDHeader);
         };
-        return dst.write(b, 4) == 4;
-    };
-    auto write_s32 = [&](int32_t v) -> bool {
-        return write_u32(static_cast<uint32_t>(v));
-    };
-
-    // --- BITMAPFILEHEADER (14 bytes) ---
-    // signature "BM"
-    unsigned char sig[2] = { 'B', 'M' };
-    if (dst.write(sig, 2) != 2) { DBG_MSG("SaveToBMP: failed writing signature\n"); return 1; }
-    // fileSize (4)
-    if (!write_u32(fileSize)) { DBG_MSG("SaveToBMP: failed writing fileSize\n"); return 1; }
-    // reserved1 (2) = 0
-    if (!write_u16(0)) { DBG_MSG("SaveToBMP: failed writing reserved1\n"); return 1; }
-    // reserved2 (2) = 0
-    if (!write_u16(0)) { DBG_MSG("SaveToBMP: failed writing reserved2\n"); return 1; }
-    // dataOffset (4)
-    if (!write_u32(dataOffset)) { DBG_MSG("SaveToBMP: failed writing dataOffset\n"); return 1; }
-
-    // --- BITMAPINFOHEADER (40 bytes) ---
-    if (!write_u32(infoSize)) { DBG_MSG("SaveToBMP: failed writing infoSize\n"); return 1; }
-    if (!write_s32(static_cast<int32_t>(width))) { DBG_MSG("SaveToBMP: failed writing width\n"); return 1; }
-    // height positive => bottom-up
-    if (!write_s32(static_cast<int32_t>(height))) { DBG_MSG("SaveToBMP: failed writing height\n"); return 1; }
-    if (!write_u16(1)) { DBG_MSG("SaveToBMP: failed writing planes\n"); return 1; }
-    if (!write_u16(static_cast<uint16_t>(bpp))) { DBG_MSG("SaveToBMP: failed writing bitsPerPixel\n"); return 1; }
-    if (!write_u32(0)) { DBG_MSG("SaveToBMP: failed writing compression\n"); return 1; } // BI_RGB
-    if (!write_u32(static_cast<uint32_t>(imageSize))) { DBG_MSG("SaveToBMP: failed writing imageSize\n"); return 1; }
-    if (!write_s32(0)) { DBG_MSG("SaveToBMP: failed writing xPelsPerMeter\n"); return 1; }
-    if (!write_s32(0)) { DBG_MSG("SaveToBMP: failed writing yPelsPerMeter\n"); return 1; }
-    if (!write_u32(0)) { DBG_MSG("SaveToBMP: failed writing clrUsed\n"); return 1; }
-    if (!write_u32(0)) { DBG_MSG("SaveToBMP: failed writing clrImportant\n"); return 1; }
-
-    // --- Pixels (BGR, bottom-up: write from bottom row to top) ---
-    std::vector<unsigned char> row(rowSize, 0);
-    for (int y = height - 1; y >= 0; --y)
-    {
-        // fill BGR row (no alpha)
-        for (int x = 0; x < width; ++x)
-        {
-            unsigned char idx = pixels[y * width + x];
-            row[x * 3 + 0] = palette[idx].b;
-            row[x * 3 + 1] = palette[idx].g;
-            row[x * 3 + 2] = palette[idx].r;
-        }
-        // padding has already been set to 0 during row initialization
-        if (dst.write(row.data(), rowSize) != static_cast<std::size_t>(rowSize))
-        {
-            DBG_MSG("SaveToBMP: failed writing pixel row %d\n", y);
-            return 1;
-        }
-    }
-
-    // Reset stream position to start (host expects this)
-    if (!dst.seek_abs(0)) { DBG_MSG("SaveToBMP: seek_abs(0) failed\n"); return 1; }
-
-#ifdef _DEBUG
-    char dbgBuf[256];
-    _snprintf_s(dbgBuf, sizeof(dbgBuf), _TRUNCATE, "SaveToBMP: OK (24bpp, %dx%d, fileSize=%u)\n", width, height, fileSize);
-    DBG_MSG(dbgBuf);
-#endif
-
-    return 0; // success
-}
-
-// ===================================================================
-// Save as TGA (always 8bpp paletted, palette 24bpp BGR,
-// ignore transparency - index 0 drawn as black)
-// We write the header field-by-field in little-endian to avoid issues
-// with padding/align between compilers.
-// Scope: internal (static)
-// ===================================================================
-static int SaveToTGA(DelphiTStreamWrapper &dst,
-              const std::vector<unsigned char> &pixels,
-              int width, int height,
-              const Color *palette_src,
-              bool useTransparency)
-{
-    // Copy palette and, if needed, zero index 0 (transparent -> black)
-    Color palette[256];
-    std::memcpy(palette, palette_src, sizeof(palette));
-    if (useTransparency)
-    {
-        palette[0].r = 0;
-        palette[0].g = 0;
-        palette[0].b = 0;
-    }
-
-    // Parameters
-    const uint8_t idLength = 0;
-    const uint8_t colorMapType = 1;    // palette present
-    const uint8_t imageType = 1;       // colormapped, uncompressed
-    const uint16_t colorMapStart = 0;
-    const uint16_t colorMapLength = 256;
-    const uint8_t colorMapBits = 24;   // 3 bytes per palette entry (B,G,R)
-    const uint16_t xOrigin = 0;
-    const uint16_t yOrigin = 0;
-    const uint16_t pixelDepth = 8;     // 8bpp indexed
-    const uint8_t imageDesc = 0x20;    // bit5 = top-left origin
-
-    // Little-endian helpers
-    auto write_u8 = [&](uint8_t v) -> bool { return dst.write(&v, 1) == 1; };
-    auto write_u16 = [&](uint16_t v) -> bool {
-        unsigned char b[2] = { static_cast<unsigned char>(v & 0xFF),
-                               static_cast<unsigned char>((v >> 8) & 0xFF) };
-        return dst.write(b, 2) == 2;
-    };
-
-    // --- Write TGA header (18 bytes) ---
-    if (!write_u8(idLength)) { DBG_MSG("SaveToTGA: failed writing idLength\n"); return 1; }
-    if (!write_u8(colorMapType)) { DBG_MSG("SaveToTGA: failed writing colorMapType\n"); return 1; }
-    if (!write_u8(imageType)) { DBG_MSG("SaveToTGA: failed writing imageType\n"); return 1; }
-    if (!write_u16(colorMapStart)) { DBG_MSG("SaveToTGA: failed writing colorMapStart\n"); return 1; }
-    if (!write_u16(colorMapLength)) { DBG_MSG("SaveToTGA: failed writing colorMapLength\n"); return 1; }
-    if (!write_u8(colorMapBits)) { DBG_MSG("SaveToTGA: failed writing colorMapBits\n"); return 1; }
-    if (!write_u16(xOrigin)) { DBG_MSG("SaveToTGA: failed writing xOrigin\n"); return 1; }
-    if (!write_u16(yOrigin)) { DBG_MSG("SaveToTGA: failed writing yOrigin\n"); return 1; }
-    if (!write_u16(static_cast<uint16_t>(width))) { DBG_MSG("SaveToTGA: failed writing width\n"); return 1; }
-    if (!write_u16(static_cast<uint16_t>(height))) { DBG_MSG("SaveToTGA: failed writing height\n"); return 1; }
-    if (!write_u8(pixelDepth)) { DBG_MSG("SaveToTGA: failed writing pixelDepth\n"); return 1; }
-    if (!write_u8(imageDesc)) { DBG_MSG("SaveToTGA: failed writing imageDesc\n"); return 1; }
-
-    // --- Write palette (256 * 3 = B,G,R) ---
-    for (int i = 0; i < 256; ++i)
-    {
-        unsigned char bgr[3] = { palette[i].b, palette[i].g, palette[i].r };
-        if (dst.write(bgr, 3) != 3) { DBG_MSG("SaveToTGA: failed writing palette entry %d\n", i); return 1; }
-    }
-
-    // --- Write pixel indices ---
-    // imageDesc = 0x20 => top-left origin, so write rows 0..height-1 in natural order
-    for (int y = 0; y < height; ++y)
-    {
-        const unsigned char *row = &pixels[y * width];
-        if (dst.write(row, width) != static_cast<std::size_t>(width))
-        {
-            DBG_MSG("SaveToTGA: failed writing pixel row %d\n", y);
-            return 1;
-        }
-    }
-
-    // Reset stream position to start (host expects this)
-    if (!dst.seek_abs(0)) { DBG_MSG("SaveToTGA: seek_abs(0) failed\n"); return 1; }
-
-#ifdef _DEBUG
-    // Direct DBG_MSG (formatted buffer, independent of macro)
-    char dbgBuf[128];
-    _snprintf_s(dbgBuf, sizeof(dbgBuf), _TRUNCATE, "SaveToTGA: OK (8bpp paletted, %dx%d)\n", width, height);
-    DBG_MSG(dbgBuf);
-#endif
+        PidInfo parsed;
+        bool isPid = readHead(0) &&
+                     PidDecoder::parse_header(buffer, got, parsed) &&
+                     PidDecoder::probe(parsed.header, size > 0 ? static_cast<std::uint64_t>(size) : 0);
 
-    return 0; // success
-}
-
-// =========================================================================================
-// Save as PNG (supports 8bpp paletted, 24bpp true-color and 32bpp RGBA)
-// =========================================================================================
-static int SaveToPNG(DelphiTStreamWrapper &dst,
-                     const std::vector<unsigned char> &pixels,
-                     int width, int height,
-                     const Color *palette,
-                     bool useTransparency)
-{
-    std::vector<char> png;
-    const unsigned char signature[] = { 0x89,'P','N','G',0x0D,0x0A,0x1A,0x0A };
-    png.insert(png.end(), std::begin(signature), std::end(signature));
-
-    // --- IHDR ---
-    struct { unsigned int w, h; unsigned char bd, ct, cm, f, i; } ihdr = {};
-    ihdr.w = _byteswap_ulong(static_cast<unsigned int>(width));
-    ihdr.h = _byteswap_ulong(static_cast<unsigned int>(height));
-    ihdr.bd = 8; // always 8 bits per channel
-    ihdr.cm = 0; ihdr.f = 0; ihdr.i = 0;
-
-    if (g_default_PNG_Mode == PNGMode::PNG_8)      ihdr.ct = 3; // indexed-color
-    else if (g_default_PNG_Mode == PNGMode::PNG_24) ihdr.ct = 2; // true-color RGB
-    else                              ihdr.ct = 6; // true-color RGBA
-
-    write_PNG_Chunk(png, "IHDR", reinterpret_cast<unsigned char *>(&ihdr), 13);
-
-    // --- PLTE / tRNS only for 8bpp ---
-    if (g_default_PNG_Mode == PNGMode::PNG_8)
-    {
-        unsigned char plte[768];
-        for (int i = 0; i < 256; ++i)
-        {
-            plte[i * 3 + 0] = palette[i].r;
-            plte[i * 3 + 1] = palette[i].g;
-            plte[i * 3 + 2] = palette[i].b;
-        }
-        write_PNG_Chunk(png, "PLTE", plte, 768);
-
-        if (useTransparency)
+        if (!isPid && entry && base && entry->offset > 0 && size > entry->offset)
         {
-            unsigned char trns[256]; std::memset(trns, 255, 256); trns[0] = 0;
-            write_PNG_Chunk(png, "tRNS", trns, 256);
-        }
-    }
-
-    // --- IDAT ---
-    std::vector<unsigned char> idat;
-    if (g_default_PNG_Mode == PNGMode::PNG_8)
-    {
-        idat.reserve(pixels.size() + height);
-        for (int y = 0; y < height; ++y)
-        {
-            idat.push_back(0); // filter
-            idat.insert(idat.end(),
-                        pixels.begin() + y * width,
-                        pixels.begin() + (y + 1) * width);
-        }
-    }
-    else if (g_default_PNG_Mode == PNGMode::PNG_24)
-    {
-        idat.reserve(width * height * 3 + height);
-        for (int y = 0; y < height; ++y)
-        {
-            idat.push_back(0); // filter
-            for (int x = 0; x < width; ++x)
+            isPid = readHead(entry->offset) &&
+                    PidDecoder::parse_header(buffer, got, parsed) &&
+                    PidDecoder::probe(parsed.header, static_cast<std::uint64_t>(size - entry->offset));
+            if (isPid)
             {
-                unsigned char idx = pixels[y * width + x];
-                idat.push_back(palette[idx].r);
-                idat.push_back(palette[idx].g);
-                idat.push_back(palette[idx].b);
+                DBG_MSG("ProbePID: entry found inside the parent stream at offset %lld\n", static_cast<long long>(entry->offset));
+                *base = entry->offset;
+                entry->size = 0;
+                entry->fingerprint = static_cast<std::uint32_t>(crc32(0L, buffer, static_cast<uInt>(got)));
+                if (info) *info = parsed;
+                return 0;
             }
+            isPid = false;
         }
+        if (entry && isPid) entry->fingerprint = static_cast<std::uint32_t>(crc32(0L, buffer, static_cast<uInt>(got)));
+
+        if (entry) ProbeCache::instance().insert(*entry, isPid);
+        if (!isPid) return 1;
+        if (info) *info = parsed;
+        return 0;
     }
-    else // PNG_32
+    catch (...)
     {
-        idat.reserve(width * height * 4 + height);
-        for (int y = 0; y < height; ++y)
-        {
-            idat.push_back(0); // filter
-            for (int x = 0; x < width; ++x)
-            {
-                unsigned char idx = pixels[y * width + x];
-                idat.push_back(palette[idx].r);
-                idat.push_back(palette[idx].g);
-                idat.push_back(palette[idx].b);
-                idat.push_back(useTransparency && idx == 0 ? 0 : 255); // alpha
-            }
-        }
+        DBG_MSG("ProbePID: exception caught\n");
+        return 1;
     }
-
-    // --- deflate compression ---
-    z_stream zs = {};
-    if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) { DBG_MSG("SaveToPNG: deflateInit failed\n"); return 1; }
-    std::vector<unsigned char> compressed(deflateBound(&zs, (uLong)idat.size()) + 16);
-    zs.next_in = idat.data(); zs.avail_in = (uInt)idat.size();
-    zs.next_out = compressed.data(); zs.avail_out = (uInt)compressed.size();
-    deflate(&zs, Z_FINISH);
-    size_t compSize = compressed.size() - zs.avail_out;
-    deflateEnd(&zs);
-
-    write_PNG_Chunk(png, "IDAT", compressed.data(), static_cast<unsigned int>(compSize));
-    write_PNG_Chunk(png, "IEND", nullptr, 0);
-
-    dst.write(png.data(), png.size());
-
-#ifdef _DEBUG
-    char dbgBuf[256];
-    const char *modeStr = (g_default_PNG_Mode == PNGMode::PNG_8) ? "8bpp paletted" :
-        (g_default_PNG_Mode == PNGMode::PNG_24) ? "24bpp true-color" :
-        "32bpp RGBA";
-    _snprintf_s(dbgBuf, sizeof(dbgBuf), _TRUNCATE,
-                "SaveToPNG: OK (%s, %dx%d)\n", modeStr, width, height);
-    DBG_MSG(dbgBuf);
-#endif // _DEBUG
-
-    return 0;
 }
 
 // ===================================================================
 // Convert PID using stream abstraction (DUCI-compatible  no direct TStream calls)
-// ===================================================================
-extern "C" int __stdcall ConvertPID(void *src, void *dst, const char *cnv)
+// - The entry is probed first (one read of the 32-byte header plus up to
+//   ProbeFingerprintBytes of pixel data, see ProbePID); anything that is
+//   not a .PID fails there, and with a key the verdict is recorded.
+// - key (optional) names the archive entry for the decode cache: a hit,
+//   verified against the header and the CRC of the entry's last bytes
+//   (one more small read), skips reading and decompressing the rest of
+//   the entry. A first miss converts through ConvertPidData
+//   (pipelined PNG, scratch arena) like an uncached call; only a repeat
+//   request for the same entry decodes it fully into the cache. Images
+//   larger than the cache capacity never go in.
+// - With key->offset set, src may also be the parent archive stream; the
+//   entry is then read in place from that offset (see ProbePID).
+// - options is the caller's snapshot of the settings (see CurrentOptions).
+// ===================================================================
+// End of a buffered entry as DecodeCache records it
+static DecodeCacheTail EntryTail(const unsigned char *data, std::size_t length)
+{
+    const std::size_t n = (std::min)(length, DecodeCache::TailBytes);
+    DecodeCacheTail tail;
+    tail.length = static_cast<std::int64_t>(length);
+    tail.crc = static_cast<std::uint32_t>(crc32(0L, data + length - n, static_cast<uInt>(n)));
+    return tail;
+}
+
+// Whether the entry at base in src still ends the way tail says
+static bool TailMatches(DelphiTStreamWrapper &src, std::int64_t base, const DecodeCacheTail &tail)
+{
+    ConvertStats::Timer timer(ConvertStats::StageRead);
+    unsigned char buffer[DecodeCache::TailBytes];
+    const std::size_t n = static_cast<std::size_t>((std::min)(tail.length, static_cast<std::int64_t>(sizeof(buffer))));
+    if (tail.length <= 0 || !src.seek_abs(base + tail.length - static_cast<std::int64_t>(n)) || src.read(buffer, n) != n)
+        return false;
+    return static_cast<std::uint32_t>(crc32(0L, buffer, static_cast<uInt>(n))) == tail.crc;
+}
+
+static int ConvertPID(void *src, void *dst, const char *cnv, const DecodeCacheKey *key,
+                      const ConvertOptions &options)
 {
     DBG_MSG("ConvertPID: called\n");
 
@@ -439,178 +233,111 @@ extern "C" int __stdcall ConvertPID(void *src, void *dst, const char *cnv)
         DelphiTStreamWrapper srcStream(src);
         DelphiTStreamWrapper dstStream(dst);
 
-        // Read PID header
-        PIDHeader header;
-        if (srcStream.read(&header, sizeof(header)) != sizeof(header))
+        // Header probe: one read of the header and the first pixel bytes
+        // identifies the entry (and fills the cache fingerprint) before the
+        // rest is read; the verdict is kept for IsFileCompatible
+        DecodeCacheKey entry;
+        if (key) entry = *key;
+        PidInfo info;
+        std::int64_t base = 0;
+        if (ProbePID(src, &info, key ? &entry : nullptr, &base) != 0)
         {
-            DBG_MSG("ConvertPID: failed reading PIDHeader\n");
+            DBG_MSG("ConvertPID: not a .PID (header probe failed)\n");
             return 1;
         }
-        DBG_MSG("ConvertPID: PIDHeader read OK\n");
-
-        // Header validation
-        if (header.ID != 10)
-        {
-            DBG_MSG("ConvertPID: header.ID != 10\n");
-            return 1;
-        }
-        if (header.Width <= 0 || header.Height <= 0)
-        {
-            DBG_MSG("ConvertPID: invalid dimensions\n");
-            return 1;
-        }
-        DBG_MSG("ConvertPID: header validation OK (W=%d H=%d)\n", header.Width, header.Height);
-
-        std::size_t pixel_count = static_cast<std::size_t>(header.Width) * static_cast<std::size_t>(header.Height);
-        if (pixel_count > (1ULL << 30))
-        {
-            DBG_MSG("ConvertPID: pixel_count too large\n");
-            return 1;
-        }
-
-        bool useTransparency = (header.Flags & 0x01) != 0;
-        bool mirror = (header.Flags & 0x08) != 0;
-        bool invert = (header.Flags & 0x10) != 0;
-        bool rleCompression = (header.Flags & 0x20) != 0;
-        bool hasPalette = (header.Flags & 0x80) != 0;
+        const PIDHeader &header = info.header;
 
-        // Palette
-        Color palette[256];
-        if (hasPalette)
+        // Decode cache lookup (header already read)
+        DecodeCache &cache = DecodeCache::instance();
+        const bool useCache = key && cache.capacity() > 0;
+        if (useCache)
         {
-            if (srcStream.seek(-768, TSeekOrigin::soFromEnd) < 0)
+            DecodeCacheTail tail;
+            std::shared_ptr<const PidImage> cached = cache.find(entry, &header, &tail);
+            if (cached && !TailMatches(srcStream, base, tail))
             {
-                DBG_MSG("ConvertPID: seek to palette failed\n");
-                return 1;
+                // Same key and header, different pixels or palette: drop it
+                DBG_MSG("ConvertPID: decode cache entry is stale (tail differs)\n");
+                cache.erase(entry);
+                cached.reset();
             }
-            DBG_MSG("ConvertPID: seeking to palette OK\n");
-
-            for (int i = 0; i < 256; ++i)
+            if (cached)
             {
-                if (srcStream.read(&palette[i].r, 1) != 1 ||
-                    srcStream.read(&palette[i].g, 1) != 1 ||
-                    srcStream.read(&palette[i].b, 1) != 1)
-                {
-                    DBG_MSG("ConvertPID: reading palette failed at index %d\n", i);
-                    return 1;
-                }
-                palette[i].a = 255;
-                if (useTransparency && i == 0) palette[i].a = 0;
+                DBG_MSG("ConvertPID: decode cache hit (W=%d H=%d)\n", cached->width, cached->height);
+                int res = SaveToFormat(dstStream, *cached, cnv, options);
+                if (res != 0) DBG_MSG("ConvertPID: SaveToFormat failed (res=%d)\n", res);
+                return res != 0 ? 1 : 0;
             }
-            DBG_MSG("ConvertPID: palette read OK\n");
         }
-        else
+        if (!srcStream.seek_abs(base))
         {
-            std::memcpy(palette, defaultPalette, sizeof(palette));
-            if (useTransparency) palette[0].a = 0;
-            DBG_MSG("ConvertPID: using default palette\n");
+            DBG_MSG("ConvertPID: seek to start failed\n");
+            return 1;
         }
 
-        // Back to pixel data (offset 32)
-        if (srcStream.seek(32, TSeekOrigin::soFromBeginning) < 0)
+        // Pull the whole .PID into memory in as few host calls as possible;
+        // the buffer and every decode/encode temporary below come from this
+        // thread's scratch arena and are reused by the next file. An entry
+        // inside the parent stream is read up to its largest possible size
+        // and then cut to the length its pixel data actually has
+        ScratchArena::Scope scratch;
+        DelphiTStreamReader input(srcStream);
+        bool buffered;
         {
-            DBG_MSG("ConvertPID: seek to pixel data failed\n");
+            ConvertStats::Timer timer(ConvertStats::StageRead);
+            buffered = base > 0 ? input.read_up_to(PidDecoder::max_entry_size(info)) : input.read_to_end();
+        }
+        if (!buffered)
+        {
+            DBG_MSG("ConvertPID: failed reading source stream\n");
             return 1;
         }
-        DBG_MSG("ConvertPID: seek to pixel data OK\n");
-
-        // Decompression
-        std::vector<unsigned char> pixels(pixel_count);
-        std::size_t pos = 0;
-        unsigned char A = 0, B = 0;
-
-        if (rleCompression)
+        std::size_t length = input.available();
+        if (base > 0)
         {
-            DBG_MSG("ConvertPID: rleCompression = true\n");
-            while (pos < pixels.size())
+            length = PidDecoder::entry_size(input.data(), input.available(), info);
+            if (length == 0)
             {
-                if (srcStream.read(&A, 1) != 1) { DBG_MSG("ConvertPID: RLE read A failed\n"); break; }
-                if (A > 128)
-                {
-                    int count = A - 128;
-                    unsigned char fill = 0;
-                    for (int i = 0; i < count && pos < pixels.size(); ++i)
-                        pixels[pos++] = fill;
-                }
-                else
-                {
-                    for (int i = 0; i < A && pos < pixels.size(); ++i)
-                    {
-                        if (srcStream.read(&B, 1) != 1) { DBG_MSG("ConvertPID: RLE read B failed\n"); pos = SIZE_MAX; break; }
-                        pixels[pos++] = B;
-                    }
-                    if (pos == SIZE_MAX) break;
-                }
+                DBG_MSG("ConvertPID: embedded entry ends early\n");
+                return 1;
             }
-        }
-        else
-        {
-            DBG_MSG("ConvertPID: rleCompression = false\n");
-            while (pos < pixels.size())
+            if (key)
             {
-                if (srcStream.read(&A, 1) != 1) { DBG_MSG("ConvertPID: raw read A failed\n"); break; }
-                int count = (A > 192) ? (A - 192) : 1;
-                if (A > 192)
-                {
-                    if (srcStream.read(&B, 1) != 1) { DBG_MSG("ConvertPID: raw read B failed\n"); break; }
-                }
-                else B = A;
-                for (int i = 0; i < count && pos < pixels.size(); ++i)
-                    pixels[pos++] = B;
+                DecodeCacheKey measured = entry;
+                measured.size = static_cast<std::int64_t>(length);
+                ProbeCache::instance().insert(measured, true);
             }
         }
+        DBG_MSG("ConvertPID: source buffered (%zu bytes)\n", length);
 
-        if (pos != pixels.size())
-        {
-            DBG_MSG("ConvertPID: decompression produced wrong size (got=%zu expected=%zu)\n", pos, pixels.size());
-            return 1;
-        }
-        DBG_MSG("ConvertPID: decompression OK\n");
-
-        // Mirror / invert
-        if (mirror || invert)
+        // Full decode into the cache on the second request for an entry
+        // that fits, so further exports (any format) skip decompression
+        if (useCache &&
+            static_cast<std::size_t>(info.width) * static_cast<std::size_t>(info.height) + sizeof(PidImage) <= cache.capacity() &&
+            cache.note_miss(entry))
         {
-            DBG_MSG("ConvertPID: mirror=%d invert=%d\n", mirror ? 1 : 0, invert ? 1 : 0);
-            std::vector<unsigned char> flipped(pixels.size());
-            for (int y = 0; y < header.Height; ++y)
+            std::shared_ptr<PidImage> image = std::make_shared<PidImage>();
+            if (!PidDecoder::decode(input.data(), length, *image, options.workers))
             {
-                int srcY = invert ? (header.Height - 1 - y) : y;
-                for (int x = 0; x < header.Width; ++x)
-                {
-                    int srcX = mirror ? (header.Width - 1 - x) : x;
-                    flipped[y * header.Width + x] = pixels[srcY * header.Width + srcX];
-                }
+                DBG_MSG("ConvertPID: decode failed\n");
+                return 1;
             }
-            pixels = std::move(flipped);
-            DBG_MSG("ConvertPID: mirror/invert applied\n");
-        }
-
-        // Write to target format
-        int res = 1;
-        if (std::strcmp(cnv, "BMP") == 0)
-        {
-            DBG_MSG("ConvertPID: target BMP\n");
-            res = SaveToBMP(dstStream, pixels, header.Width, header.Height, palette, useTransparency);
-        }
-        else if (std::strcmp(cnv, "TGA8") == 0 || std::strcmp(cnv, "TGA") == 0)
-        {
-            DBG_MSG("ConvertPID: target TGA\n");
-            res = SaveToTGA(dstStream, pixels, header.Width, header.Height, palette, useTransparency);
-        }
-        else if (std::strcmp(cnv, "PNG") == 0)
-        {
-            DBG_MSG("ConvertPID: target PNG\n");
-            res = SaveToPNG(dstStream, pixels, header.Width, header.Height, palette, useTransparency);
-        }
-        else
-        {
-            DBG_MSG("ConvertPID: unsupported target format: %s\n", cnv ? cnv : "(null)");
-            return 1;
+            cache.insert(entry, image, EntryTail(input.data(), length));
+            int res = SaveToFormat(dstStream, *image, cnv, options);
+            if (res != 0)
+            {
+                DBG_MSG("ConvertPID: SaveToFormat failed (res=%d)\n", res);
+                return 1;
+            }
+            DBG_MSG("ConvertPID: success (cached)\n");
+            return 0;
         }
 
+        // Decode (full or pipelined scanlines) and write to target format
+        int res = ConvertPidData(dstStream, input.data(), length, cnv, options);
         if (res != 0)
         {
-            DBG_MSG("ConvertPID: SaveToX failed (res=%d)\n", res);
+            DBG_MSG("ConvertPID: conversion failed (res=%d)\n", res);
             return 1;
         }
 
@@ -650,18 +377,33 @@ extern "C" __declspec(dllexport) ConvertInfoRec __stdcall VersionInfo2()
 }
 
 // ===================================================================
-// Exported: Check if file is compatible (only .pid extension, independent of fmt)
+// Entry identification for IsFileCompatible / GetFileConvert
+// - Neither call gets the entry's bytes, so a probe verdict recorded by
+//   an earlier ConvertStream on the same entry (name, offset, size) wins;
+//   otherwise the .pid extension decides.
+// - An entry too short to hold a PIDHeader is never a .PID.
+// ===================================================================
+static bool IsPidEntry(const std::string &nam, INT64 Offset, INT64 Size)
+{
+    if (nam.empty()) return false;
+    if (Size > 0 && Size < static_cast<INT64>(sizeof(PIDHeader))) return false;
+
+    ProbeCache::Verdict verdict = ProbeCache::instance().find(DecodeCacheKey{ nam, Offset, Size });
+    if (verdict != ProbeCache::Unknown) return verdict == ProbeCache::IsPid;
+
+    size_t dot_pos = nam.rfind('.');
+    return dot_pos != std::string::npos && _stricmp(nam.substr(dot_pos).c_str(), ".pid") == 0;
+}
+
+// ===================================================================
+// Exported: Check if file is compatible (header probe verdict or .pid extension, independent of fmt)
 // ===================================================================
 extern "C" DBOOL __stdcall IsFileCompatible(const ShortString *nam_ss, INT64 Offset, INT64 Size, const ShortString *fmt_ss, int DataX, int DataY)
 {
-    (void)Offset; (void)Size; (void)DataX; (void)DataY;
+    (void)DataX; (void)DataY;
     std::string nam = ShortStringPtrToString(nam_ss);
     std::string fmt = ShortStringPtrToString(fmt_ss);
-    if (nam.empty()) return FALSE;
-    size_t dot_pos = nam.rfind('.');
-    if (dot_pos == std::string::npos) return FALSE;
-    std::string ext = nam.substr(dot_pos);
-    bool isCompatible = (_stricmp(ext.c_str(), ".pid") == 0);
+    bool isCompatible = IsPidEntry(nam, Offset, Size);
 #ifdef _DEBUG
     std::string msg = "IsFileCompatible(): " + std::string(isCompatible ? "True" : "False") + " (nam=" + nam + ", fmt=" + fmt + ")";
     OutputDebugStringA((msg + "\n").c_str());
@@ -693,15 +435,14 @@ extern "C" __declspec(dllexport) ConvertList __stdcall GetFileConvert(
     DBG_MSG((msg + "\n").c_str());
 #endif
 
-    // Check extension
-    size_t dot_pos = nam.rfind('.');
-    if (dot_pos == std::string::npos || _stricmp(nam.substr(dot_pos).c_str(), ".PID") != 0)
+    // Check probe verdict / extension
+    if (!IsPidEntry(nam, Offset, Size))
     {
         DBG_MSG("GetFileConvert: not a .PID file, returning empty list\n");
         return result;
     }
 
-    result.NumFormats = 3;
+    result.NumFormats = 5;
 
     WriteShortString(result.List[0].Display, "BMP - Windows Bitmap (24bpp)");
     WriteShortString(result.List[0].Ext, "bmp");
@@ -711,10 +452,18 @@ extern "C" __declspec(dllexport) ConvertList __stdcall GetFileConvert(
     WriteShortString(result.List[1].Ext, "tga");
     WriteShortString(result.List[1].ID, "TGA8");
 
-    WriteShortString(result.List[2].Display, (std::string("PNG - Portable Network Graphics (") + std::to_string(static_cast<unsigned short>(g_default_PNG_Mode)) + "bpp)").c_str());
+    WriteShortString(result.List[2].Display, (std::string("PNG - Portable Network Graphics (") + std::to_string(static_cast<unsigned short>(CurrentOptions().pngMode)) + "bpp)").c_str());
     WriteShortString(result.List[2].Ext, "png");
     WriteShortString(result.List[2].ID, "PNG");
 
+    WriteShortString(result.List[3].Display, "TGA - Targa (8bpp Colormap, RLE)");
+    WriteShortString(result.List[3].Ext, "tga");
+    WriteShortString(result.List[3].ID, "TGA8RLE");
+
+    WriteShortString(result.List[4].Display, "RAW8 + PAL - 8bpp indices with palette (engine data)");
+    WriteShortString(result.List[4].Ext, "raw");
+    WriteShortString(result.List[4].ID, "RAW8");
+
 #ifdef _DEBUG
     DBG_MSG("GetFileConvert: returning %d formats\n", (int)result.NumFormats);
 #endif
@@ -734,7 +483,7 @@ extern "C" __declspec(dllexport) int __stdcall ConvertStream(
     int DataX, int DataY,
     DBOOL Silent)
 {
-    (void)Offset; (void)DataX; (void)DataY; (void)Silent;
+    (void)DataX; (void)DataY; (void)Silent;
 
     std::string nam = ShortStringPtrToString(nam_ss);
     std::string fmt = ShortStringPtrToString(fmt_ss);
@@ -747,19 +496,126 @@ extern "C" __declspec(dllexport) int __stdcall ConvertStream(
     OutputDebugStringA((msg + "\n").c_str());
 #endif
 
+    // Entry identity for the decode cache (size is filled from the stream);
+    // Offset also locates the entry when src is the whole archive
+    DecodeCacheKey key = { nam, Offset, 0 };
+
     // Returns 0 on success, non-zero on error
-    return ConvertPID(src, dst, cnv.c_str());
+    ConvertStats::Conversion record;
+    return record.done(ConvertPID(src, dst, cnv.c_str(), &key, CurrentOptions()));
 }
 
 // ===================================================================
-// Exported: File-based conversion wrapper (for older DUCI)
+// Multi-format branch of Convert()
+// - dstFile keeps its directory and base name, the extension is replaced
+//   per target (see ExportSuffix), encoders run concurrently.
+// ===================================================================
+static int ExportFormats(const MappedFile &input, const PidInfo &header, const std::string &dstFile,
+                         const std::vector<std::string> &formats, const ConvertOptions &options)
+{
+    std::size_t slash = dstFile.find_last_of("\\/");
+    std::size_t dot = dstFile.rfind('.');
+    std::string base = (dot != std::string::npos && (slash == std::string::npos || dot > slash)) ? dstFile.substr(0, dot) : dstFile;
+
+    std::vector<std::unique_ptr<MemoryStream>> outputs;
+    std::vector<ExportTarget<MemoryStream>> targets(formats.size());
+    for (std::size_t i = 0; i < formats.size(); ++i)
+    {
+        if (!FormatExtension(formats[i].c_str()))
+        {
+            DBG_MSG("Convert: unsupported target format: %s\n", formats[i].c_str());
+            return 1;
+        }
+        outputs.emplace_back(new MemoryStream(EstimateOutputSize(header, formats[i].c_str(), options)));
+        targets[i].cnv = formats[i].c_str();
+        targets[i].output = outputs.back().get();
+    }
+
+    if (ExportPidData(input.data(), input.size(), targets.data(), targets.size(), options, true) != 0)
+    {
+        DBG_MSG("Convert: multi-format export failed\n");
+        return 1;
+    }
+
+    for (std::size_t i = 0; i < formats.size(); ++i)
+    {
+        std::string path = base + ExportSuffix(formats, i);
+        if (!WriteWholeFile(path.c_str(), outputs[i]->data().data(), outputs[i]->data().size()))
+        {
+            DBG_MSG("Convert: writing %s failed\n", path.c_str());
+            return 1;
+        }
+    }
+    DBG_MSG("Convert: exported %zu formats\n", formats.size());
+    return 0;
+}
+
+// ===================================================================
+// Exported: File-based conversion (for older DUCI hosts)
+// - Source .PID is memory-mapped and decoded in place (no copy),
+//   the complete output is written with a single WriteFile call.
+// - cnv may list several IDs ("BMP,PNG"): the source is decoded once
+//   and every format is written next to dstFile (see ExportFormats).
 // ===================================================================
 extern "C" int __stdcall Convert(const ShortString *srcFile_ss, const ShortString *dstFile_ss,
                                  const ShortString *nam_ss, const ShortString *fmt_ss, const ShortString *cnv_ss, INT64 Offset, int DataX, int DataY, DBOOL Silent)
 {
-    // Not used  host should use ConvertStream
-    // Could implement a simple wrapper to ConvertStream if needed
-    return 1;
+    (void)nam_ss; (void)fmt_ss; (void)Offset; (void)DataX; (void)DataY; (void)Silent;
+
+    std::string srcFile = ShortStringPtrToString(srcFile_ss);
+    std::string dstFile = ShortStringPtrToString(dstFile_ss);
+    std::string cnv = ShortStringPtrToString(cnv_ss);
+    if (srcFile.empty() || dstFile.empty() || cnv.empty()) return 1;
+
+#ifdef _DEBUG
+    std::string msg = "Convert called (cnv=" + cnv + ", src=" + srcFile + ", dst=" + dstFile + ")";
+    OutputDebugStringA((msg + "\n").c_str());
+#endif
+
+    ConvertStats::Conversion record;
+    try
+    {
+        MappedFile input;
+        if (!input.open(srcFile.c_str()))
+        {
+            DBG_MSG("Convert: cannot map source file\n");
+            return 1;
+        }
+
+        PidInfo header;
+        if (!PidDecoder::parse_header(input.data(), input.size(), header))
+        {
+            DBG_MSG("Convert: invalid header\n");
+            return 1;
+        }
+
+        const ConvertOptions options = CurrentOptions();
+
+        // "BMP,PNG,..." - decode once, encode every target, one file each
+        std::vector<std::string> formats = SplitFormatList(cnv);
+        if (formats.size() > 1) return record.done(ExportFormats(input, header, dstFile, formats, options));
+
+        MemoryStream output(EstimateOutputSize(header, cnv.c_str(), options));
+        if (ConvertPidData(output, input.data(), input.size(), cnv.c_str(), options) != 0)
+        {
+            DBG_MSG("Convert: conversion failed\n");
+            return 1;
+        }
+
+        if (!WriteWholeFile(dstFile.c_str(), output.data().data(), output.data().size()))
+        {
+            DBG_MSG("Convert: writing destination file failed\n");
+            return 1;
+        }
+
+        DBG_MSG("Convert: success (%zu bytes)\n", output.data().size());
+        return record.done(0);
+    }
+    catch (...)
+    {
+        DBG_MSG("Convert: exception caught\n");
+        return 1;
+    }
 }
 
 // ===================================================================
@@ -786,32 +642,67 @@ extern "C" void __stdcall InitPluginEx4(TMsgBoxCallback MsgBox)
 }
 
 // ConfigDlgProc: dialog procedure for the plugin's setup window,
-// allowing the user to choose the default PNG export mode (8/24/32 bpp).
+// allowing the user to choose the default PNG export mode (8/24/32 bpp)
+// the PNG compression preset (fast / balanced / smallest) and the memory
+// cap of the decode cache (MB, 0 = disabled); "Statistics..." shows the
+// session counters (ConvertStats).
 INT_PTR CALLBACK ConfigDlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam)
 {
     switch (msg)
     {
     case WM_INITDIALOG:
+    {
         // Mark the currently selected mode
+        const ConvertOptions options = CurrentOptions();
         CheckRadioButton(hDlg, IDC_RADIO_PNG8, IDC_RADIO_PNG32,
-                         (g_default_PNG_Mode == PNGMode::PNG_8) ? IDC_RADIO_PNG8 :
-                         (g_default_PNG_Mode == PNGMode::PNG_24) ? IDC_RADIO_PNG24 :
+                         (options.pngMode == PNGMode::PNG_8) ? IDC_RADIO_PNG8 :
+                         (options.pngMode == PNGMode::PNG_24) ? IDC_RADIO_PNG24 :
                          IDC_RADIO_PNG32);
+        CheckRadioButton(hDlg, IDC_RADIO_PNG_FAST, IDC_RADIO_PNG_SMALLEST,
+                         (options.pngCompression == PNGCompression::Fast) ? IDC_RADIO_PNG_FAST :
+                         (options.pngCompression == PNGCompression::Smallest) ? IDC_RADIO_PNG_SMALLEST :
+                         IDC_RADIO_PNG_BALANCED);
+        SetDlgItemInt(hDlg, IDC_EDIT_CACHE_MB, static_cast<UINT>(DecodeCache::instance().capacity() / (1024 * 1024)), FALSE);
         return TRUE;
+    }
 
     case WM_COMMAND:
         switch (LOWORD(wParam))
         {
         case IDOK:
+        {
+            ConvertOptions options = CurrentOptions();
             if (IsDlgButtonChecked(hDlg, IDC_RADIO_PNG8) == BST_CHECKED)
-                g_default_PNG_Mode = PNGMode::PNG_8;
+                options.pngMode = PNGMode::PNG_8;
             else if (IsDlgButtonChecked(hDlg, IDC_RADIO_PNG24) == BST_CHECKED)
-                g_default_PNG_Mode = PNGMode::PNG_24;
+                options.pngMode = PNGMode::PNG_24;
             else if (IsDlgButtonChecked(hDlg, IDC_RADIO_PNG32) == BST_CHECKED)
-                g_default_PNG_Mode = PNGMode::PNG_32;
+                options.pngMode = PNGMode::PNG_32;
+
+            if (IsDlgButtonChecked(hDlg, IDC_RADIO_PNG_FAST) == BST_CHECKED)
+                options.pngCompression = PNGCompression::Fast;
+            else if (IsDlgButtonChecked(hDlg, IDC_RADIO_PNG_BALANCED) == BST_CHECKED)
+                options.pngCompression = PNGCompression::Balanced;
+            else if (IsDlgButtonChecked(hDlg, IDC_RADIO_PNG_SMALLEST) == BST_CHECKED)
+                options.pngCompression = PNGCompression::Smallest;
+            StoreOptions(options);
+
+            {
+                BOOL ok = FALSE;
+                UINT mb = GetDlgItemInt(hDlg, IDC_EDIT_CACHE_MB, &ok, FALSE);
+                if (ok) DecodeCache::instance().set_capacity(static_cast<std::size_t>(mb) * 1024 * 1024);
+            }
 
             EndDialog(hDlg, IDOK);
             return TRUE;
+        }
+
+        case IDC_BUTTON_STATS:
+        {
+            const std::string report = ConvertStats::report(ConvertStats::instance().snapshot());
+            MessageBoxA(hDlg, report.c_str(), "Session statistics", MB_OK | MB_ICONINFORMATION);
+            return TRUE;
+        }
 
         case IDCANCEL:
             EndDialog(hDlg, IDCANCEL);
@@ -871,8 +762,12 @@ extern "C" void __stdcall ConfigBox()
 // ===================================================================
 extern "C" void __stdcall AboutBox()
 {
+    // About text followed by the counters of this session
+    std::string text(MSG_about);
+    text += "\n\nThis session:\n";
+    text += ConvertStats::report(ConvertStats::instance().snapshot());
     MessageBoxA(AHandle ? AHandle : GetActiveWindow(),
-                MSG_about.data(),
+                text.c_str(),
                 "About .PID converter",
                 MB_OK | MB_ICONINFORMATION);
 }
@@ -885,6 +780,7 @@ extern "C" void __stdcall AboutBox()
 static_assert(sizeof(ShortString) == 256, "ShortString size mismatch");
 static_assert(sizeof(ConvertInfoRec) == 1028, "ConvertInfoRec size mismatch");
 static_assert(sizeof(ConvertListElem) == 768, "ConvertListElem size mismatch");
+static_assert(sizeof(RawIndexHeader) == 40, "RawIndexHeader size mismatch");
 
 // Log on attach (debug)
 DBOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserved)
@@ -0,0 +1,543 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_decoder.cpp
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Stream-agnostic .PID decode engine
+ *
+ *  DETAILS:
+ *      Implementation of PidDecoder: header validation, palette resolution,
+ *      RLE / raw decompression with mirror/invert folded into the output
+ *      cursor (one instance per flag combination), and the row-at-a-time
+ *      PidScanlineDecoder, all on an in-memory span. Decodes are counted
+ *      and timed in ConvertStats.
+ * ============================================================================
+ */
+
+#ifdef _DEBUG
+#include <windows.h> // OutputDebugStringA for DBG_MSG
+#endif
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include "pid_arena.h"
+#include "pid_decoder.h"
+#include "pid_parallel.h"
+#include "pid_simd.h"
+#include "pid_stats.h"
+
+
+// ===================================================================
+// Header
+// ===================================================================
+bool PidDecoder::parse_header(const unsigned char *data, std::size_t size, PidInfo &info)
+{
+    if (!data || size < sizeof(PIDHeader))
+    {
+        DBG_MSG("PidDecoder: file too short for PIDHeader\n");
+        return false;
+    }
+    std::memcpy(&info.header, data, sizeof(PIDHeader));
+    const PIDHeader &header = info.header;
+
+    if (header.ID != 10)
+    {
+        DBG_MSG("PidDecoder: header.ID != 10\n");
+        return false;
+    }
+    if (header.Width <= 0 || header.Height <= 0)
+    {
+        DBG_MSG("PidDecoder: invalid dimensions\n");
+        return false;
+    }
+
+    std::size_t pixel_count = static_cast<std::size_t>(header.Width) * static_cast<std::size_t>(header.Height);
+    if (pixel_count > (1ULL << 30))
+    {
+        DBG_MSG("PidDecoder: pixel_count too large\n");
+        return false;
+    }
+
+    info.width = header.Width;
+    info.height = header.Height;
+    info.useTransparency = (header.Flags & PID_FLAG_TRANSPARENT) != 0;
+    info.mirror = (header.Flags & PID_FLAG_MIRROR) != 0;
+    info.invert = (header.Flags & PID_FLAG_INVERT) != 0;
+    info.rleCompression = (header.Flags & PID_FLAG_RLE) != 0;
+    info.hasPalette = (header.Flags & PID_FLAG_PALETTE) != 0;
+    return true;
+}
+
+// ===================================================================
+// Header probe (identification only, nothing is decoded)
+// ===================================================================
+bool PidDecoder::probe(const PIDHeader &header, std::uint64_t entrySize)
+{
+    if (header.ID != 10) return false;
+    if (header.Width <= 0 || header.Height <= 0) return false;
+    if ((header.Flags & ~PID_FLAG_MASK) != 0) return false;
+    if (static_cast<std::uint64_t>(header.Width) * static_cast<std::uint64_t>(header.Height) > (1ULL << 30)) return false;
+    if (entrySize != 0)
+    {
+        const std::uint64_t minimum = sizeof(PIDHeader) + ((header.Flags & PID_FLAG_PALETTE) ? 768 : 0);
+        if (entrySize < minimum) return false;
+    }
+    return true;
+}
+
+// ===================================================================
+// Palette (embedded or default)
+// ===================================================================
+bool PidDecoder::load_palette(const unsigned char *data, std::size_t size, PidImage &image)
+{
+    if (image.hasPalette)
+    {
+        if (size < 768)
+        {
+            DBG_MSG("PidDecoder: file too short for embedded palette\n");
+            return false;
+        }
+        const unsigned char *rgb = data + size - 768;
+        for (int i = 0; i < 256; ++i)
+        {
+            image.palette[i].r = rgb[i * 3 + 0];
+            image.palette[i].g = rgb[i * 3 + 1];
+            image.palette[i].b = rgb[i * 3 + 2];
+            image.palette[i].a = 255;
+        }
+    }
+    else
+    {
+        std::memcpy(image.palette, defaultPalette, sizeof(image.palette));
+    }
+    if (image.useTransparency) image.palette[0].a = 0;
+    return true;
+}
+
+// ===================================================================
+// Output cursor with mirror/invert folded in
+// - Decoded row r lands in image row (invert ? height-1-r : r), so
+//   inverted images are written bottom-up directly.
+// - Mirrored rows are decoded left-to-right and reversed in place as
+//   soon as they are complete (while still in cache).
+// - Runs are written with memset/memcpy per row segment, so the bounds
+//   check happens once per run instead of once per pixel.
+// - Mirror and Invert are template constants: decompress() picks one of
+//   the four cursors once per file, so the row switch carries no flag tests.
+// ===================================================================
+namespace
+{
+    template <bool Mirror, bool Invert>
+    struct RowCursor
+    {
+        unsigned char *base;
+        std::size_t width;
+        int height;
+
+        int row = 0;                    // decoded row index
+        std::size_t x = 0;              // column inside the current row
+        unsigned char *line = nullptr;  // start of the current destination row
+
+        RowCursor(unsigned char *pixels, int w, int h)
+            : base(pixels), width(static_cast<std::size_t>(w)), height(h)
+        {
+            line = row_start(0);
+        }
+
+        unsigned char *row_start(int r) const
+        {
+            int y = Invert ? (height - 1 - r) : r;
+            return base + static_cast<std::size_t>(y) * width;
+        }
+
+        bool done() const { return row >= height; }
+
+        // Pixels still to produce before the image is complete
+        std::size_t remaining() const
+        {
+            return done() ? 0 : static_cast<std::size_t>(height - row) * width - x;
+        }
+
+        void put(unsigned char value)
+        {
+            line[x] = value;
+            advance(1);
+        }
+
+        // Block fill of count pixels (clamped to the image), crossing rows
+        void fill(unsigned char value, std::size_t count)
+        {
+            count = (std::min)(count, remaining());
+            while (count > 0)
+            {
+                std::size_t n = (std::min)(count, width - x);
+                std::memset(line + x, value, n);
+                advance(n);
+                count -= n;
+            }
+        }
+
+        // Block copy of count pixels from src; caller guarantees count <= remaining()
+        void copy(const unsigned char *src, std::size_t count)
+        {
+            while (count > 0)
+            {
+                std::size_t n = (std::min)(count, width - x);
+                std::memcpy(line + x, src, n);
+                advance(n);
+                src += n;
+                count -= n;
+            }
+        }
+
+        void advance(std::size_t n)
+        {
+            x += n;
+            if (x == width) next_row();
+        }
+
+        void next_row()
+        {
+            if constexpr (Mirror) ReverseBytes(line, width);
+            x = 0;
+            if (++row < height) line = row_start(row);
+        }
+
+        std::size_t produced() const { return static_cast<std::size_t>(row) * width + x; }
+    };
+
+    // Pixel stream from src into the plane through a RowCursor
+    // - Returns: false if the data ends before width*height pixels.
+    template <bool Mirror, bool Invert>
+    bool DecompressInto(const unsigned char *src, const unsigned char *end, const PidInfo &info, unsigned char *pixels)
+    {
+        RowCursor<Mirror, Invert> out(pixels, info.width, info.height);
+
+        if (info.rleCompression)
+        {
+            // A > 128 : (A - 128) transparent pixels
+            // A <= 128: A literal indices follow
+            while (!out.done())
+            {
+                if (src == end) { DBG_MSG("PidDecoder: RLE data ended early\n"); break; }
+                unsigned char A = *src++;
+                if (A > 128)
+                {
+                    out.fill(0, A - 128);
+                }
+                else
+                {
+                    // one bounds check per literal run (clamped to the image)
+                    std::size_t count = (std::min)(static_cast<std::size_t>(A), out.remaining());
+                    if (static_cast<std::size_t>(end - src) < count) { DBG_MSG("PidDecoder: RLE literal ended early\n"); return false; }
+                    out.copy(src, count);
+                    src += count;
+                }
+            }
+        }
+        else
+        {
+            // A > 192 : next byte repeated (A - 192) times
+            // A <= 192: A itself is the pixel index
+            while (!out.done())
+            {
+                if (src == end) { DBG_MSG("PidDecoder: raw data ended early\n"); break; }
+                unsigned char A = *src++;
+                if (A > 192)
+                {
+                    if (src == end) { DBG_MSG("PidDecoder: raw repeat value missing\n"); break; }
+                    out.fill(*src++, A - 192);
+                }
+                else
+                {
+                    out.put(A);
+                }
+            }
+        }
+
+        if (!out.done())
+        {
+            DBG_MSG("PidDecoder: decompression produced wrong size (got=%zu expected=%zu)\n", out.produced(),
+                    static_cast<std::size_t>(info.width) * static_cast<std::size_t>(info.height));
+            return false;
+        }
+        return true;
+    }
+}
+
+// ===================================================================
+// Decompression (RLE or raw/repeat coding, data starts at offset 32)
+// ===================================================================
+bool PidDecoder::decompress(const unsigned char *data, std::size_t size, PidImage &image)
+{
+    image.pixels.resize(static_cast<std::size_t>(image.width) * static_cast<std::size_t>(image.height));
+    return decompress(data, size, image, image.pixels.data());
+}
+
+bool PidDecoder::decompress(const unsigned char *data, std::size_t size, const PidInfo &info, unsigned char *pixels)
+{
+    ConvertStats::Timer timer(ConvertStats::StageDecode);
+    const unsigned char *src = data + sizeof(PIDHeader);
+    const unsigned char *end = data + size;
+
+    const std::size_t pixel_count = static_cast<std::size_t>(info.width) * static_cast<std::size_t>(info.height);
+    const bool ok = info.mirror ? (info.invert ? DecompressInto<true, true>(src, end, info, pixels)
+                                               : DecompressInto<true, false>(src, end, info, pixels))
+                                : (info.invert ? DecompressInto<false, true>(src, end, info, pixels)
+                                               : DecompressInto<false, false>(src, end, info, pixels));
+    if (!ok) return false;
+    ConvertStats::instance().decoded(pixel_count, size, info.mirror, info.invert);
+    return true;
+}
+
+// ===================================================================
+// Full decode
+// ===================================================================
+bool PidDecoder::decode(const unsigned char *data, std::size_t size, PidImage &image, unsigned workers)
+{
+    if (!parse_header(data, size, image)) return false;
+    if (!load_palette(data, size, image)) return false;
+    if (workers == 1) return decompress(data, size, image);
+    image.pixels.resize(static_cast<std::size_t>(image.width) * static_cast<std::size_t>(image.height));
+    return decompress_parallel(data, size, image, image.pixels.data(), workers);
+}
+
+// ===================================================================
+// Row index and banded decode
+// - The index pass only steps over runs (RLE literals are skipped by
+//   pointer arithmetic), so it costs a fraction of the decode itself.
+// - Band b writes only its own rows of the plane, so the threads share
+//   nothing but the read-only source and index.
+// ===================================================================
+bool PidDecoder::index_rows(const unsigned char *data, std::size_t size, const PidInfo &info,
+                            int bandRows, PidRowIndex &index)
+{
+    index.bandRows = (std::max)(bandRows, 1);
+    index.bands.clear();
+    if (size < sizeof(PIDHeader)) return false;
+    index.bands.reserve(static_cast<std::size_t>((info.height + index.bandRows - 1) / index.bandRows));
+
+    PidScanlineDecoder walker(data, size, info);
+    for (int y = 0; y < info.height; y += index.bandRows)
+    {
+        index.bands.push_back(walker.position());
+        if (!walker.skip_rows((std::min)(index.bandRows, info.height - y))) return false;
+    }
+    return true;
+}
+
+bool PidDecoder::decompress_parallel(const unsigned char *data, std::size_t size, const PidInfo &info,
+                                     unsigned char *pixels, unsigned workers)
+{
+    const std::size_t width = static_cast<std::size_t>(info.width);
+    const std::size_t pixel_count = width * static_cast<std::size_t>(info.height);
+    if (workers == 1 || pixel_count < ParallelMinPixels || ResolveWorkers(workers) < 2)
+        return decompress(data, size, info, pixels);
+
+    ConvertStats::Timer timer(ConvertStats::StageDecode);
+    ScratchArena::Scope scratch;
+    PidRowIndex index;
+    const int bandRows = static_cast<int>((std::max)(ParallelBandPixels / width, static_cast<std::size_t>(1)));
+    if (!index_rows(data, size, info, bandRows, index))
+    {
+        DBG_MSG("PidDecoder: pixel data is truncated\n");
+        return false;
+    }
+
+    const bool ok = ParallelFor(index.bands.size(), workers, [&](std::size_t b) {
+        ScratchArena::Scope local;
+        PidScanlineDecoder band(data, size, info);
+        band.seek(index.bands[b]);
+        const int y0 = static_cast<int>(b) * index.bandRows;
+        const int y1 = (std::min)(y0 + index.bandRows, info.height);
+        for (int r = y0; r < y1; ++r)
+        {
+            const int y = info.invert ? (info.height - 1 - r) : r;
+            if (!band.read_row(pixels + static_cast<std::size_t>(y) * width)) return false;
+        }
+        return true;
+    });
+    if (!ok)
+    {
+        DBG_MSG("PidDecoder: banded decode failed\n");
+        return false;
+    }
+    ConvertStats::instance().decoded(pixel_count, size, info.mirror, info.invert);
+    return true;
+}
+
+// ===================================================================
+// Entry length (data of unknown extent)
+// ===================================================================
+std::size_t PidDecoder::entry_size(const unsigned char *data, std::size_t size, const PidInfo &info)
+{
+    if (size < sizeof(PIDHeader)) return 0;
+    PidScanlineDecoder walker(data, size, info);
+    std::size_t end = walker.end_offset();
+    if (end == 0) return 0;
+    if (info.hasPalette) end += 768;
+    return end <= size ? end : 0;
+}
+
+std::size_t PidDecoder::max_entry_size(const PidInfo &info)
+{
+    const std::size_t pixels = static_cast<std::size_t>(info.width) * static_cast<std::size_t>(info.height);
+    return sizeof(PIDHeader) + 2 * pixels + (info.hasPalette ? 768 : 0);
+}
+
+// ===================================================================
+// Scanline decoder
+// ===================================================================
+PidScanlineDecoder::PidScanlineDecoder(const unsigned char *data, std::size_t size, const PidInfo &image)
+    : fBegin(data + sizeof(PIDHeader)), fEnd(data + size), fSrc(data + sizeof(PIDHeader)),
+      fWidth(static_cast<std::size_t>(image.width)), fHeight(image.height),
+      fRle(image.rleCompression), fMirror(image.mirror),
+      fRow(ScratchArena::local().alloc_array<unsigned char>(static_cast<std::size_t>(image.width)))
+{
+}
+
+void PidScanlineDecoder::rewind()
+{
+    fSrc = fBegin;
+    fRunLeft = 0;
+    fNextRow = 0;
+}
+
+bool PidScanlineDecoder::advance(unsigned char *out, std::size_t count)
+{
+    while (count > 0)
+    {
+        if (fRunLeft == 0)
+        {
+            // Next control byte
+            if (fSrc == fEnd) { DBG_MSG("PidScanlineDecoder: data ended early\n"); return false; }
+            unsigned char A = *fSrc++;
+            if (fRle)
+            {
+                // A > 128 : (A - 128) transparent pixels, A <= 128: A literal indices
+                fRunLiteral = (A <= 128);
+                fRunValue = 0;
+                fRunLeft = fRunLiteral ? A : static_cast<std::size_t>(A - 128);
+            }
+            else
+            {
+                // A > 192 : next byte repeated (A - 192) times, A <= 192: A is the index
+                fRunLiteral = false;
+                fRunValue = A;
+                fRunLeft = 1;
+                if (A > 192)
+                {
+                    if (fSrc == fEnd) { DBG_MSG("PidScanlineDecoder: raw repeat value missing\n"); return false; }
+                    fRunValue = *fSrc++;
+                    fRunLeft = A - 192;
+                }
+            }
+            continue;
+        }
+
+        const std::size_t n = fRunLeft < count ? fRunLeft : count;
+        if (fRunLiteral)
+        {
+            if (static_cast<std::size_t>(fEnd - fSrc) < n) { DBG_MSG("PidScanlineDecoder: literal ended early\n"); return false; }
+            if (out) std::memcpy(out, fSrc, n);
+            fSrc += n;
+        }
+        else if (out)
+        {
+            std::memset(out, fRunValue, n);
+        }
+        if (out) out += n;
+        fRunLeft -= n;
+        count -= n;
+    }
+    return true;
+}
+
+PidStreamPos PidScanlineDecoder::position() const
+{
+    PidStreamPos pos;
+    pos.offset = static_cast<std::size_t>(fSrc - fBegin);
+    pos.runLeft = fRunLeft;
+    pos.runLiteral = fRunLiteral;
+    pos.runValue = fRunValue;
+    pos.row = fNextRow;
+    return pos;
+}
+
+void PidScanlineDecoder::seek(const PidStreamPos &pos)
+{
+    fSrc = fBegin + pos.offset;
+    fRunLeft = pos.runLeft;
+    fRunLiteral = pos.runLiteral;
+    fRunValue = pos.runValue;
+    fNextRow = pos.row;
+}
+
+bool PidScanlineDecoder::read_row(unsigned char *out)
+{
+    if (fNextRow >= fHeight || !advance(out, fWidth)) return false;
+    ++fNextRow;
+    if (fMirror) ReverseBytes(out, fWidth);
+    return true;
+}
+
+bool PidScanlineDecoder::skip_rows(int count)
+{
+    if (count < 0 || count > fHeight - fNextRow) return false;
+    if (!advance(nullptr, static_cast<std::size_t>(count) * fWidth)) return false;
+    fNextRow += count;
+    return true;
+}
+
+const unsigned char *PidScanlineDecoder::row(int y)
+{
+    if (y < 0 || y >= fHeight) return nullptr;
+    if (y < fNextRow) rewind();
+    if (y > fNextRow && !skip_rows(y - fNextRow)) return nullptr;
+    return read_row(fRow) ? fRow : nullptr;
+}
+
+bool PidScanlineDecoder::validate()
+{
+    ConvertStats::Timer timer(ConvertStats::StageDecode);
+    rewind();
+    const std::size_t pixels = fWidth * static_cast<std::size_t>(fHeight);
+    bool ok = advance(nullptr, pixels);
+    rewind();
+    // The rows themselves are produced (and timed) inside the encoder
+    if (ok) ConvertStats::instance().decoded(pixels, static_cast<std::size_t>(fEnd - fBegin) + sizeof(PIDHeader), fMirror, false);
+    return ok;
+}
+
+std::size_t PidScanlineDecoder::end_offset()
+{
+    rewind();
+    const bool ok = advance(nullptr, fWidth * static_cast<std::size_t>(fHeight));
+    // A literal run cut off by the image end still owns its bytes
+    const std::size_t end = static_cast<std::size_t>(fSrc - fBegin) + sizeof(PIDHeader) + (fRunLiteral ? fRunLeft : 0);
+    rewind();
+    return ok ? end : 0;
+}
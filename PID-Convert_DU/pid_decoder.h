@@ -0,0 +1,276 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_decoder.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Stream-agnostic .PID decode engine
+ *
+ *  DETAILS:
+ *      Declares PidInfo (header fields only), PidImage (PidInfo plus
+ *      palette and index plane) and PidDecoder, which probes or parses the
+ *      PIDHeader, resolves the palette (embedded or default) and
+ *      decompresses RLE/raw pixel data with mirror/invert applied on the
+ *      fly, plus PidScanlineDecoder, which yields one row at a time for
+ *      pipelined encoders. Large images can be indexed by row band and
+ *      decoded on several threads. Works on a plain memory span, so the
+ *      same code is driven by the DU5 plugin, the command-line tools and
+ *      benchmarks without the Delphi ABI in the loop.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef PID_DECODER_H
+#define PID_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "pid_convert.h"
+
+
+// =======================
+// .PID metadata (header only)
+// =======================
+// Everything parse_header() knows: enough for listings without decoding.
+struct PidInfo
+{
+    PIDHeader header;                   // header as stored in the file (incl. U[4] offsets)
+    int width = 0;
+    int height = 0;
+
+    bool useTransparency = false;       // flag 0x01 - index 0 is transparent
+    bool mirror = false;                // flag 0x08 - stored right-to-left
+    bool invert = false;                // flag 0x10 - stored bottom-up
+    bool rleCompression = false;        // flag 0x20 - RLE, otherwise raw/repeat coding
+    bool hasPalette = false;            // flag 0x80 - 768-byte palette at the end of file
+};
+
+
+// =======================
+// Decoded .PID image
+// =======================
+struct PidImage : PidInfo
+{
+    Color palette[256];                 // resolved palette (alpha of index 0 = 0 if transparent)
+    std::vector<unsigned char> pixels;  // width*height indices, top-down, flips applied
+};
+
+
+// =======================
+// Row index (parallel decode)
+// =======================
+// Decoder position at the start of a stored row: the source offset plus
+// the run still pending from the row before (runs may cross rows).
+struct PidStreamPos
+{
+    std::size_t offset = 0;             // bytes after the 32-byte header
+    std::size_t runLeft = 0;
+    bool runLiteral = false;
+    unsigned char runValue = 0;
+    int row = 0;                        // stored row decoded next
+};
+
+// Positions of every bandRows-th stored row, from PidDecoder::index_rows()
+struct PidRowIndex
+{
+    int bandRows = 0;                   // rows per band (the last one may be shorter)
+    std::vector<PidStreamPos> bands;    // bands[b] = position of stored row b * bandRows
+};
+
+
+// =======================
+// Decoder
+// =======================
+// All methods work on a complete .PID file held in memory
+// (data points at the PIDHeader, size is the whole file size).
+class PidDecoder
+{
+public:
+    // ------------------------------------------------------------------
+    // parse_header()
+    // ------------------------------------------------------------------
+    // Reads and validates the PIDHeader and fills the size/flag fields of info
+    // (a PidImage or a bare PidInfo; only the first 32 bytes are touched).
+    // - Returns: true if ID == 10 and dimensions are sane, false otherwise.
+    static bool parse_header(const unsigned char *data, std::size_t size, PidInfo &info);
+
+    // ------------------------------------------------------------------
+    // probe()
+    // ------------------------------------------------------------------
+    // Identification from the 32-byte header alone: ID == 10, sane
+    // Width/Height, no flag bits above 0xFF and, when entrySize is known
+    // (non-zero), room for the header plus the embedded palette.
+    // - Returns: true if the header looks like a .PID.
+    static bool probe(const PIDHeader &header, std::uint64_t entrySize = 0);
+
+    // ------------------------------------------------------------------
+    // load_palette()
+    // ------------------------------------------------------------------
+    // Resolves image.palette: embedded table (last 768 bytes) if flag 0x80 is set,
+    // defaultPalette otherwise. Index 0 gets alpha 0 when transparency is on.
+    // - Returns: false if the file is too short to hold the embedded palette.
+    static bool load_palette(const unsigned char *data, std::size_t size, PidImage &image);
+
+    // ------------------------------------------------------------------
+    // decompress()
+    // ------------------------------------------------------------------
+    // Expands the pixel data (starting at offset 32) into image.pixels,
+    // applying the mirror/invert flags while writing (no second pass).
+    // - Returns: false if the data ends before width*height pixels were produced.
+    static bool decompress(const unsigned char *data, std::size_t size, PidImage &image);
+
+    // Same, into a caller-provided plane of info.width * info.height bytes
+    // (e.g. from the scratch arena); info only needs parse_header().
+    static bool decompress(const unsigned char *data, std::size_t size, const PidInfo &info, unsigned char *pixels);
+
+    // ------------------------------------------------------------------
+    // index_rows()
+    // ------------------------------------------------------------------
+    // Walks the whole pixel stream once (no pixels are written) and
+    // records where every bandRows-th stored row starts. Uses a
+    // PidScanlineDecoder, so the caller must hold a ScratchArena::Scope.
+    // - Returns: false if the data ends before width*height pixels.
+    static bool index_rows(const unsigned char *data, std::size_t size, const PidInfo &info,
+                           int bandRows, PidRowIndex &index);
+
+    // ------------------------------------------------------------------
+    // decompress_parallel()
+    // ------------------------------------------------------------------
+    // Same result as decompress(), but for images of ParallelMinPixels or
+    // more (pid_parallel.h) the stream is indexed by row band first and the
+    // bands are decoded on up to workers threads (0 = one per core), each
+    // straight into its rows of the plane. Smaller images, and workers == 1,
+    // take the sequential decompress().
+    static bool decompress_parallel(const unsigned char *data, std::size_t size, const PidInfo &info,
+                                    unsigned char *pixels, unsigned workers);
+
+    // ------------------------------------------------------------------
+    // decode()
+    // ------------------------------------------------------------------
+    // Full pipeline: parse_header + load_palette + decompress
+    // (decompress_parallel with the given workers setting).
+    // - Returns: true on success.
+    static bool decode(const unsigned char *data, std::size_t size, PidImage &image, unsigned workers = 1);
+
+    // ------------------------------------------------------------------
+    // entry_size()
+    // ------------------------------------------------------------------
+    // Length of a .PID whose end is not known (an entry read straight from
+    // its parent archive): header, the pixel data as far as decompress()
+    // consumes it, plus the 768-byte palette if flag 0x80 is set. size only
+    // bounds the walk; max_entry_size() bytes are always enough. Uses a
+    // PidScanlineDecoder, so the caller must hold a ScratchArena::Scope.
+    // - Returns: the length, or 0 if data ends before the image does.
+    static std::size_t entry_size(const unsigned char *data, std::size_t size, const PidInfo &info);
+
+    // Upper bound of entry_size(): 2 bytes per pixel (a raw-coded index
+    // above 192 or a 1-pixel RLE literal) plus header and palette
+    static std::size_t max_entry_size(const PidInfo &info);
+};
+
+
+// =======================
+// Scanline decoder
+// =======================
+// Pipelined alternative to PidDecoder::decompress: produces one row at a
+// time into an internal width-sized buffer, so the full index plane never
+// exists in memory. Rows come out in stored order with the mirror flag
+// applied; the invert flag is NOT applied (row r is image row H-1-r when
+// set); callers that need top-down rows either seek by row band from a
+// PidRowIndex (see PidInvertedRows in pid_encoders.h) or use decode().
+// The row buffer comes from ScratchArena::local(), so a decoder must not
+// outlive the ScratchArena::Scope it was created under.
+class PidScanlineDecoder
+{
+public:
+    // data/size: complete .PID file; image: filled by parse_header()
+    PidScanlineDecoder(const unsigned char *data, std::size_t size, const PidInfo &image);
+
+    // ------------------------------------------------------------------
+    // row()
+    // ------------------------------------------------------------------
+    // Returns stored row y (width indices, valid until the next call).
+    // Rows are decoded sequentially; asking for an earlier row rewinds.
+    // - Returns: nullptr if the data ends before row y is complete.
+    const unsigned char *row(int y);
+
+    // ------------------------------------------------------------------
+    // validate()
+    // ------------------------------------------------------------------
+    // Walks the whole pixel stream without writing anything and rewinds.
+    // - Returns: true if the data holds width*height pixels (the same
+    //   condition under which decode() succeeds).
+    bool validate();
+
+    // ------------------------------------------------------------------
+    // end_offset()
+    // ------------------------------------------------------------------
+    // Walks the whole pixel stream like validate() and rewinds.
+    // - Returns: offset just past the last pixel byte (counted from the
+    //   start of the file), 0 if the data ends before width*height pixels.
+    std::size_t end_offset();
+
+    void rewind();
+
+    // ------------------------------------------------------------------
+    // position() / seek()
+    // ------------------------------------------------------------------
+    // Current position at a row boundary, and a jump back to one taken
+    // earlier from a decoder over the same data (see PidRowIndex).
+    PidStreamPos position() const;
+    void seek(const PidStreamPos &pos);
+
+    // ------------------------------------------------------------------
+    // read_row() / skip_rows()
+    // ------------------------------------------------------------------
+    // Decodes the next stored row into out (width bytes, mirror applied),
+    // or steps over count rows without writing them.
+    // - Returns: false if the data ends first.
+    bool read_row(unsigned char *out);
+    bool skip_rows(int count);
+
+private:
+    // Produces count pixels into out (nullptr = skip), crossing runs as needed
+    bool advance(unsigned char *out, std::size_t count);
+
+    const unsigned char *fBegin;
+    const unsigned char *fEnd;
+    const unsigned char *fSrc;
+    std::size_t fWidth;
+    int fHeight;
+    bool fRle;
+    bool fMirror;
+
+    // Pending run left over from the previous row
+    std::size_t fRunLeft = 0;       // pixels still owed by the current control byte
+    bool fRunLiteral = false;       // true: copy from fSrc, false: fill with fRunValue
+    unsigned char fRunValue = 0;
+
+    int fNextRow = 0;               // stored row that the next advance() produces
+    unsigned char *fRow;            // width bytes from the scratch arena
+};
+
+#endif // PID_DECODER_H
@@ -0,0 +1,129 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_deflate.cpp
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Per-thread pool of reusable zlib deflate streams
+ *
+ *  DETAILS:
+ *      Implementation of DeflatePool (deflateReset on a parameter match,
+ *      least recently used free slot otherwise) and its Lease, plus the
+ *      thread_local instance behind local().
+ * ============================================================================
+ */
+
+#include "pid_deflate.h"
+
+
+// ===================================================================
+// Pool
+// ===================================================================
+DeflatePool::~DeflatePool()
+{
+    for (Slot &slot : fSlots)
+        if (slot.init) deflateEnd(&slot.zs);
+}
+
+int DeflatePool::acquire(int level, int memLevel, int strategy)
+{
+    // Same configuration: deflateReset keeps the allocations
+    for (int i = 0; i < MaxStreams; ++i)
+    {
+        Slot &slot = fSlots[i];
+        if (slot.busy || !slot.init || slot.level != level || slot.memLevel != memLevel || slot.strategy != strategy)
+            continue;
+        if (deflateReset(&slot.zs) != Z_OK)
+        {
+            deflateEnd(&slot.zs);
+            slot.init = false;
+            break;
+        }
+        slot.busy = true;
+        slot.lastUse = ++fClock;
+        ++fResets;
+        return i;
+    }
+
+    // Otherwise an empty slot, or the least recently used idle one
+    int victim = -1;
+    for (int i = 0; i < MaxStreams; ++i)
+    {
+        const Slot &slot = fSlots[i];
+        if (slot.busy) continue;
+        if (!slot.init) { victim = i; break; }
+        if (victim < 0 || slot.lastUse < fSlots[victim].lastUse) victim = i;
+    }
+    if (victim < 0) return -1;
+
+    Slot &slot = fSlots[victim];
+    if (slot.init) deflateEnd(&slot.zs);
+    slot.zs = z_stream();
+    slot.init = (deflateInit2(&slot.zs, level, Z_DEFLATED, 15, memLevel, strategy) == Z_OK);
+    if (!slot.init) return -1;
+    ++fInits;
+    slot.level = level;
+    slot.memLevel = memLevel;
+    slot.strategy = strategy;
+    slot.busy = true;
+    slot.lastUse = ++fClock;
+    return victim;
+}
+
+DeflatePool &DeflatePool::local()
+{
+    static thread_local DeflatePool pool;
+    return pool;
+}
+
+// ===================================================================
+// Lease
+// ===================================================================
+bool DeflatePool::Lease::open(int level, int memLevel, int strategy)
+{
+    close();
+    fSlot = fPool.acquire(level, memLevel, strategy);
+    if (fSlot >= 0)
+    {
+        fStream = &fPool.fSlots[fSlot].zs;
+        return true;
+    }
+
+    // Pool exhausted (or init failed there): private stream
+    fPrivate = z_stream();
+    if (deflateInit2(&fPrivate, level, Z_DEFLATED, 15, memLevel, strategy) != Z_OK) return false;
+    ++fPool.fInits;
+    fStream = &fPrivate;
+    return true;
+}
+
+void DeflatePool::Lease::close()
+{
+    if (!fStream) return;
+    if (fSlot >= 0) fPool.fSlots[fSlot].busy = false;
+    else deflateEnd(&fPrivate);
+    fStream = nullptr;
+    fSlot = -1;
+}
@@ -0,0 +1,120 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_deflate.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Per-thread pool of reusable zlib deflate streams
+ *
+ *  DETAILS:
+ *      deflateInit2 allocates the window, hash chains and pending buffer
+ *      (a few hundred KB) and deflateEnd frees them again; for sprites of a
+ *      few KB that setup costs more than the compression itself. DeflatePool
+ *      keeps a handful of initialized z_streams per thread, keyed by
+ *      level / memLevel / strategy, and hands them out through
+ *      DeflatePool::Lease after a deflateReset, so a batch (or a series of
+ *      host calls into the plugin) initializes each configuration once.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef PID_DEFLATE_H
+#define PID_DEFLATE_H
+
+#include <cstdint>
+#include <zlib.h>
+
+
+// =======================
+// Deflate stream pool
+// =======================
+// Not thread-safe by design: each thread uses its own local() pool.
+// Streams always use a 32K window (windowBits 15, zlib wrapper, as PNG
+// requires) and no preset dictionary (PNG forbids FDICT in IDAT).
+class DeflatePool
+{
+public:
+    static constexpr int MaxStreams = 4;    // Fast, Balanced and both Smallest strategies fit
+
+    // ------------------------------------------------------------------
+    // Lease
+    // ------------------------------------------------------------------
+    // One z_stream, ready for deflate() after open(). Pooled streams go
+    // back to the pool on destruction; if every slot is busy, the lease
+    // falls back to a private stream that is ended on destruction.
+    class Lease
+    {
+    public:
+        explicit Lease(DeflatePool &pool = DeflatePool::local()) : fPool(pool) {}
+        ~Lease() { close(); }
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+        // Returns false if zlib cannot initialize the stream
+        bool open(int level, int memLevel, int strategy);
+        void close();
+
+        z_stream *get() const { return fStream; }
+
+    private:
+        DeflatePool &fPool;
+        z_stream *fStream = nullptr;
+        int fSlot = -1;             // pool slot, -1 for the private stream
+        z_stream fPrivate = {};
+    };
+
+    DeflatePool() = default;
+    ~DeflatePool();
+    DeflatePool(const DeflatePool &) = delete;
+    DeflatePool &operator=(const DeflatePool &) = delete;
+
+    std::uint64_t inits() const { return fInits; }     // deflateInit2 calls (pooled and private)
+    std::uint64_t resets() const { return fResets; }   // leases served by deflateReset
+
+    // Pool of the calling thread
+    static DeflatePool &local();
+
+private:
+    struct Slot
+    {
+        z_stream zs = {};
+        int level = 0;
+        int memLevel = 0;
+        int strategy = 0;
+        bool init = false;
+        bool busy = false;
+        std::uint64_t lastUse = 0;
+    };
+
+    // Reset matching stream or (re)initialized free slot; -1 if none is free
+    int acquire(int level, int memLevel, int strategy);
+
+    Slot fSlots[MaxStreams];
+    std::uint64_t fClock = 0;
+    std::uint64_t fInits = 0;
+    std::uint64_t fResets = 0;
+};
+
+#endif // PID_DEFLATE_H
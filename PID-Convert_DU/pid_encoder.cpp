@@ -0,0 +1,464 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_encoder.cpp
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      .PID encoder (index plane and palette back to .PID)
+ *
+ *  DETAILS:
+ *      Implementation of PidEncoder: greedy and optimal RLE packing, the
+ *      raw/repeat coding, median-cut quantization and nearest-color
+ *      mapping. Parse tables and stored-order rows come from the
+ *      per-thread ScratchArena; encodes are counted in ConvertStats.
+ * ============================================================================
+ */
+
+#ifdef _DEBUG
+#include <windows.h> // OutputDebugStringA for DBG_MSG
+#endif
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+#include "pid_arena.h"
+#include "pid_encoder.h"
+#include "pid_simd.h"
+#include "pid_stats.h"
+
+
+// ===================================================================
+// Whole file
+// ===================================================================
+int PidEncoder::header_flags(const PidImage &image)
+{
+    // Bits the format does not define (0x02/0x04/0x40) are kept as they came
+    const int known = PID_FLAG_TRANSPARENT | PID_FLAG_MIRROR | PID_FLAG_INVERT | PID_FLAG_RLE | PID_FLAG_PALETTE;
+    return (image.header.Flags & PID_FLAG_MASK & ~known) |
+        (image.useTransparency ? PID_FLAG_TRANSPARENT : 0) | (image.mirror ? PID_FLAG_MIRROR : 0) |
+        (image.invert ? PID_FLAG_INVERT : 0) | (image.rleCompression ? PID_FLAG_RLE : 0) |
+        (image.hasPalette ? PID_FLAG_PALETTE : 0);
+}
+
+bool PidEncoder::encode(const PidImage &image, PidRlePacking packing, std::vector<unsigned char> &out)
+{
+    if (image.width <= 0 || image.height <= 0) return false;
+    const std::size_t width = static_cast<std::size_t>(image.width);
+    const std::size_t count = width * static_cast<std::size_t>(image.height);
+    if (image.pixels.size() < count)
+    {
+        DBG_MSG("PidEncoder: index plane too short\n");
+        return false;
+    }
+    ConvertStats::Timer timer(ConvertStats::StageEncode);
+
+    PIDHeader header = image.header;
+    header.ID = 10;
+    header.Flags = header_flags(image);
+    header.Width = image.width;
+    header.Height = image.height;
+
+    out.clear();
+    out.reserve(sizeof(PIDHeader) + count + count / 64 + 16 + (image.hasPalette ? 768 : 0));
+    const unsigned char *raw = reinterpret_cast<const unsigned char *>(&header);
+    out.insert(out.end(), raw, raw + sizeof(header));
+
+    // Rows in stored order: the decoder reverses mirrored rows and writes
+    // inverted ones bottom-up, so the same is done here the other way round
+    ScratchArena::Scope scratch;
+    const unsigned char *stored = image.pixels.data();
+    if (image.mirror || image.invert)
+    {
+        unsigned char *rows = scratch.arena().alloc_array<unsigned char>(count);
+        for (int r = 0; r < image.height; ++r)
+        {
+            const int y = image.invert ? (image.height - 1 - r) : r;
+            unsigned char *line = rows + static_cast<std::size_t>(r) * width;
+            std::memcpy(line, image.pixels.data() + static_cast<std::size_t>(y) * width, width);
+            if (image.mirror) ReverseBytes(line, width);
+        }
+        stored = rows;
+    }
+
+    if (image.rleCompression) pack_rle(stored, count, packing, out);
+    else                      pack_raw(stored, count, out);
+
+    if (image.hasPalette)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            out.push_back(image.palette[i].r);
+            out.push_back(image.palette[i].g);
+            out.push_back(image.palette[i].b);
+        }
+    }
+    ConvertStats::instance().encoded(count, out.size());
+    return true;
+}
+
+// ===================================================================
+// RLE packing
+// - Codes: 129..255 = 1..127 zeros, 1..128 = that many literal indices
+//   (zeros may sit inside a literal, 0 is never emitted).
+// - A zero run costs 1 byte, a literal of n costs n + 1, so a single
+//   zero is cheaper inside a literal and a longer run is cheaper alone.
+// ===================================================================
+namespace
+{
+    void EmitZeros(std::size_t count, std::vector<unsigned char> &out)
+    {
+        while (count > 0)
+        {
+            const std::size_t n = (std::min)(count, static_cast<std::size_t>(127));
+            out.push_back(static_cast<unsigned char>(128 + n));
+            count -= n;
+        }
+    }
+
+    void EmitLiteral(const unsigned char *pixels, std::size_t count, std::vector<unsigned char> &out)
+    {
+        out.push_back(static_cast<unsigned char>(count));
+        out.insert(out.end(), pixels, pixels + count);
+    }
+
+    void PackGreedy(const unsigned char *pixels, std::size_t count, std::vector<unsigned char> &out)
+    {
+        std::size_t literal = 0;    // start of the open literal
+        std::size_t length = 0;     // its length so far (0 = none open)
+        std::size_t i = 0;
+        while (i < count)
+        {
+            if (pixels[i] == 0)
+            {
+                std::size_t zeros = 1;
+                while (i + zeros < count && pixels[i + zeros] == 0) ++zeros;
+                if (zeros >= 2 || length == 0)
+                {
+                    if (length) EmitLiteral(pixels + literal, length, out);
+                    length = 0;
+                    EmitZeros(zeros, out);
+                    i += zeros;
+                    continue;
+                }
+            }
+            if (length == 0) literal = i;
+            if (++length == 128)
+            {
+                EmitLiteral(pixels + literal, length, out);
+                length = 0;
+            }
+            ++i;
+        }
+        if (length) EmitLiteral(pixels + literal, length, out);
+    }
+
+    // Shortest parse of the whole stream:
+    //   cost[i] = bytes for the first i pixels
+    //           = min(cost[j] + 1          for a zero run j..i, i - j <= 127,
+    //                 cost[j] + (i - j) + 1 for a literal j..i, i - j <= 128)
+    // cost is nondecreasing, so the best zero run starts as early as the
+    // run allows; the literal term is a sliding-window minimum of
+    // cost[j] - j, kept in a monotone deque. Only the last 128 costs are
+    // ever read, so cost and the deque live in small rings; the run choice
+    // per end (1 byte per pixel) is all that spans the image. O(count) time.
+    void PackOptimal(const unsigned char *pixels, std::size_t count, std::vector<unsigned char> &out)
+    {
+        const std::size_t Ring = 256;   // > 128 + 1 live entries, power of two
+        std::uint64_t cost[Ring];
+        std::size_t deque[Ring];
+        std::size_t head = 0, tail = 0; // positions in deque, taken mod Ring
+
+        ScratchArena::Scope scratch;
+        unsigned char *last = scratch.arena().alloc_array<unsigned char>(count + 1);    // last run: length - 1, 0x80 = zeros
+
+        // cost[j] - j, shifted to stay unsigned
+        auto key = [&](std::size_t j) { return cost[j % Ring] + (count - j); };
+
+        cost[0] = 0;
+        std::size_t zeroStart = 0;
+        for (std::size_t i = 1; i <= count; ++i)
+        {
+            const std::size_t j0 = i - 1;
+            while (tail > head && key(deque[(tail - 1) % Ring]) >= key(j0)) --tail;
+            deque[tail++ % Ring] = j0;
+            while (deque[head % Ring] + 128 < i) ++head;
+
+            const std::size_t from = deque[head % Ring];
+            std::uint64_t best = cost[from % Ring] + (i - from) + 1;
+            unsigned char run = static_cast<unsigned char>(i - from - 1);
+
+            if (pixels[i - 1] == 0)
+            {
+                if (i == 1 || pixels[i - 2] != 0) zeroStart = i - 1;
+                const std::size_t j = (std::max)(zeroStart, i > 127 ? i - 127 : 0);
+                if (cost[j % Ring] + 1 < best)
+                {
+                    best = cost[j % Ring] + 1;
+                    run = static_cast<unsigned char>(0x80 | (i - j - 1));
+                }
+            }
+            cost[i % Ring] = best;
+            last[i] = run;
+        }
+
+        // Walk back over the chosen runs and copy each one's choice to its
+        // first slot (begin + 1, inside the run, so no other chosen end is
+        // overwritten), then emit them front to back
+        for (std::size_t i = count; i > 0;)
+        {
+            const std::size_t begin = i - ((last[i] & 0x7F) + 1);
+            last[begin + 1] = last[i];
+            i = begin;
+        }
+        for (std::size_t begin = 0; begin < count;)
+        {
+            const unsigned char run = last[begin + 1];
+            const std::size_t end = begin + (run & 0x7F) + 1;
+            if (run & 0x80) EmitZeros(end - begin, out);
+            else            EmitLiteral(pixels + begin, end - begin, out);
+            begin = end;
+        }
+    }
+}
+
+void PidEncoder::pack_rle(const unsigned char *pixels, std::size_t count, PidRlePacking packing, std::vector<unsigned char> &out)
+{
+    if (packing == PidRlePacking::Greedy)
+    {
+        PackGreedy(pixels, count, out);
+        return;
+    }
+    PackOptimal(pixels, count, out);
+}
+
+// ===================================================================
+// Raw/repeat coding
+// - 0..192 is the index itself, 193..255 repeats the next byte 1..63
+//   times, so indices above 192 always need a 2-byte repeat code.
+// - Per run of one index: full 63-repeats, a remainder of 1 or 2 as
+//   single bytes (if the index allows it), otherwise one more repeat.
+//   That is already the shortest coding, no search needed.
+// ===================================================================
+void PidEncoder::pack_raw(const unsigned char *pixels, std::size_t count, std::vector<unsigned char> &out)
+{
+    std::size_t i = 0;
+    while (i < count)
+    {
+        const unsigned char value = pixels[i];
+        std::size_t run = 1;
+        while (i + run < count && pixels[i + run] == value) ++run;
+        i += run;
+        while (run > 0)
+        {
+            if (value <= 192 && run <= 2)
+            {
+                out.push_back(value);
+                --run;
+                continue;
+            }
+            const std::size_t n = (std::min)(run, static_cast<std::size_t>(63));
+            out.push_back(static_cast<unsigned char>(192 + n));
+            out.push_back(value);
+            run -= n;
+        }
+    }
+}
+
+// ===================================================================
+// Palette generation (exact or median cut)
+// ===================================================================
+namespace
+{
+    inline std::uint32_t RgbKey(const Color &c)
+    {
+        return PackColorBytes(c.r, c.g, c.b, 0);
+    }
+
+    struct HistEntry
+    {
+        unsigned char rgb[3];
+        std::uint32_t count;
+    };
+
+    struct CutBox
+    {
+        std::size_t begin, end;     // range of HistEntry
+        int channel;                // widest channel
+        int range;                  // its extent (0 = cannot be split)
+    };
+
+    void MeasureBox(const std::vector<HistEntry> &hist, CutBox &box)
+    {
+        unsigned char lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+        for (std::size_t i = box.begin; i < box.end; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                lo[c] = (std::min)(lo[c], hist[i].rgb[c]);
+                hi[c] = (std::max)(hi[c], hist[i].rgb[c]);
+            }
+        }
+        box.channel = 0;
+        box.range = 0;
+        for (int c = 0; c < 3; ++c)
+        {
+            if (hi[c] - lo[c] > box.range)
+            {
+                box.range = hi[c] - lo[c];
+                box.channel = c;
+            }
+        }
+    }
+}
+
+void PidEncoder::quantize(const Color *pixels, std::size_t count, bool reserveZero, Color palette[256])
+{
+    for (int i = 0; i < 256; ++i) palette[i] = Color{ 0, 0, 0, 255 };
+    const int first = reserveZero ? 1 : 0;
+    const std::size_t slots = static_cast<std::size_t>(256 - first);
+
+    // Distinct colors in order of first use, with pixel counts
+    std::vector<HistEntry> hist;
+    std::unordered_map<std::uint32_t, std::size_t> seen;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (reserveZero && pixels[i].a < 128) continue;
+        auto found = seen.emplace(RgbKey(pixels[i]), hist.size());
+        if (found.second) hist.push_back(HistEntry{ { pixels[i].r, pixels[i].g, pixels[i].b }, 0 });
+        ++hist[found.first->second].count;
+    }
+
+    if (hist.size() <= slots)
+    {
+        // The most common color goes to index 0: zero runs are what RLE codes cheaply
+        if (!reserveZero && !hist.empty())
+        {
+            std::size_t top = 0;
+            for (std::size_t i = 1; i < hist.size(); ++i)
+                if (hist[i].count > hist[top].count) top = i;
+            std::swap(hist[0], hist[top]);
+        }
+        for (std::size_t i = 0; i < hist.size(); ++i)
+            palette[first + i] = Color{ hist[i].rgb[0], hist[i].rgb[1], hist[i].rgb[2], 255 };
+        return;
+    }
+
+    // Median cut: split the box with the widest channel at its weighted median
+    std::vector<CutBox> boxes(1, CutBox{ 0, hist.size(), 0, 0 });
+    MeasureBox(hist, boxes[0]);
+    while (boxes.size() < slots)
+    {
+        std::size_t pick = boxes.size();
+        for (std::size_t b = 0; b < boxes.size(); ++b)
+            if (boxes[b].range > 0 && (pick == boxes.size() || boxes[b].range > boxes[pick].range)) pick = b;
+        if (pick == boxes.size()) break;
+
+        CutBox box = boxes[pick];
+        const int c = box.channel;
+        std::sort(hist.begin() + box.begin, hist.begin() + box.end,
+                  [c](const HistEntry &a, const HistEntry &b) { return a.rgb[c] < b.rgb[c]; });
+        std::uint64_t total = 0, acc = 0;
+        for (std::size_t i = box.begin; i < box.end; ++i) total += hist[i].count;
+        std::size_t split = box.begin + 1;
+        for (std::size_t i = box.begin; i + 1 < box.end; ++i)
+        {
+            acc += hist[i].count;
+            split = i + 1;
+            if (2 * acc >= total) break;
+        }
+
+        CutBox left = { box.begin, split, 0, 0 }, right = { split, box.end, 0, 0 };
+        MeasureBox(hist, left);
+        MeasureBox(hist, right);
+        boxes[pick] = left;
+        boxes.push_back(right);
+    }
+
+    // Each box becomes its count-weighted mean color (the heaviest one at index 0, as above)
+    std::uint64_t heaviest = 0;
+    std::size_t top = 0;
+    for (std::size_t b = 0; b < boxes.size(); ++b)
+    {
+        std::uint64_t sum[3] = { 0, 0, 0 }, total = 0;
+        for (std::size_t i = boxes[b].begin; i < boxes[b].end; ++i)
+        {
+            for (int c = 0; c < 3; ++c) sum[c] += static_cast<std::uint64_t>(hist[i].rgb[c]) * hist[i].count;
+            total += hist[i].count;
+        }
+        Color &entry = palette[first + b];
+        entry.r = static_cast<unsigned char>((sum[0] + total / 2) / total);
+        entry.g = static_cast<unsigned char>((sum[1] + total / 2) / total);
+        entry.b = static_cast<unsigned char>((sum[2] + total / 2) / total);
+        entry.a = 255;
+        if (total > heaviest) { heaviest = total; top = b; }
+    }
+    if (!reserveZero) std::swap(palette[0], palette[top]);
+}
+
+// ===================================================================
+// Nearest-color mapping
+// - Results are cached per distinct color, so the 256-entry search runs
+//   once per color rather than once per pixel.
+// ===================================================================
+void PidEncoder::map_colors(const Color *pixels, std::size_t count, const Color palette[256], bool transparent,
+                            unsigned char *indices)
+{
+    const int first = transparent ? 1 : 0;
+    std::unordered_map<std::uint32_t, unsigned char> cache;
+    std::uint32_t lastKey = 0;
+    unsigned char lastIndex = 0;
+    bool haveLast = false;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (transparent && pixels[i].a < 128) { indices[i] = 0; continue; }
+        const std::uint32_t key = RgbKey(pixels[i]);
+        if (haveLast && key == lastKey) { indices[i] = lastIndex; continue; }
+
+        auto found = cache.find(key);
+        if (found == cache.end())
+        {
+            int best = first;
+            long bestDistance = -1;
+            for (int p = first; p < 256; ++p)
+            {
+                const long dr = static_cast<long>(pixels[i].r) - palette[p].r;
+                const long dg = static_cast<long>(pixels[i].g) - palette[p].g;
+                const long db = static_cast<long>(pixels[i].b) - palette[p].b;
+                const long distance = dr * dr + dg * dg + db * db;
+                if (bestDistance < 0 || distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                    if (distance == 0) break;
+                }
+            }
+            found = cache.emplace(key, static_cast<unsigned char>(best)).first;
+        }
+        indices[i] = lastIndex = found->second;
+        lastKey = key;
+        haveLast = true;
+    }
+}
@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_encoder.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      .PID encoder (index plane and palette back to .PID)
+ *
+ *  DETAILS:
+ *      The inverse of PidDecoder: PidEncoder::encode writes a PidImage
+ *      (size, flags, U[4], palette, top-down index plane) as a complete
+ *      .PID file that PidDecoder decodes back to exactly the same plane.
+ *      Pixel data is packed either as RLE (A > 128: A - 128 zeros,
+ *      A <= 128: A literal indices), greedily or with a byte-optimal
+ *      parse, or with the raw/repeat coding. map_colors / quantize turn
+ *      true-color pixels into indices for a given or a generated palette.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef PID_ENCODER_H
+#define PID_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "pid_convert.h"
+#include "pid_decoder.h"
+
+
+// RLE run selection
+enum class PidRlePacking : unsigned char
+{
+    Greedy,     // zero runs of 2+ pixels end a literal, everything else joins it
+    Optimal     // shortest possible stream (dynamic programming over run choices)
+};
+
+
+// =======================
+// Encoder
+// =======================
+class PidEncoder
+{
+public:
+    // ------------------------------------------------------------------
+    // encode()
+    // ------------------------------------------------------------------
+    // Writes image as a .PID: header from image.width/height, the flag
+    // fields (useTransparency, mirror, invert, rleCompression, hasPalette)
+    // and image.header.U, then the pixel data in stored order (rows
+    // reversed / bottom-up as the mirror / invert flags say, so the decoder
+    // restores image.pixels), then the 768-byte palette if hasPalette.
+    // - Returns: false if the image is empty or pixels is too short.
+    static bool encode(const PidImage &image, PidRlePacking packing, std::vector<unsigned char> &out);
+
+    // ------------------------------------------------------------------
+    // header_flags()
+    // ------------------------------------------------------------------
+    // The PIDHeader.Flags value encode() writes for image: the flag fields
+    // as bits, plus any bits of image.header.Flags the format does not
+    // define (0x02/0x04/0x40), kept as they came.
+    static int header_flags(const PidImage &image);
+
+    // ------------------------------------------------------------------
+    // pack_rle() / pack_raw()
+    // ------------------------------------------------------------------
+    // Append the coded form of count indices (in stored order) to out.
+    static void pack_rle(const unsigned char *pixels, std::size_t count, PidRlePacking packing, std::vector<unsigned char> &out);
+    static void pack_raw(const unsigned char *pixels, std::size_t count, std::vector<unsigned char> &out);
+
+    // ------------------------------------------------------------------
+    // quantize()
+    // ------------------------------------------------------------------
+    // Builds a palette for count RGBA pixels. Pixels with alpha < 128 are
+    // skipped when reserveZero is set (index 0 stays for them). Up to 256
+    // (255) distinct colors are taken as they are, in order of first use;
+    // more are reduced by median cut. Without reserveZero the most common
+    // color is moved to index 0, so RLE codes it as zero runs. Unused
+    // entries are black.
+    static void quantize(const Color *pixels, std::size_t count, bool reserveZero, Color palette[256]);
+
+    // ------------------------------------------------------------------
+    // map_colors()
+    // ------------------------------------------------------------------
+    // Nearest palette index (squared RGB distance, first match wins) for
+    // every pixel. With transparent set, pixels with alpha < 128 become
+    // index 0 and the rest are matched against indices 1..255 only.
+    static void map_colors(const Color *pixels, std::size_t count, const Color palette[256], bool transparent,
+                           unsigned char *indices);
+};
+
+#endif // PID_ENCODER_H
@@ -0,0 +1,1479 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_encoders.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      BMP / TGA / PNG / RAW8 writers shared by plugin and tools
+ *
+ *  DETAILS:
+ *      SaveToBMP (24bpp BGR), SaveToTGA / SaveToTGARLE (8bpp paletted,
+ *      uncompressed or type-9 RLE), SaveToPNG
+ *      (8/24/32bpp, adaptive row filters, deflated row by row into
+ *      bounded IDAT chunks; the scanline code is instantiated per bit
+ *      depth and chosen once per file) and SaveToRAW8 (header, palette and the
+ *      index plane as is), templated on the destination stream, plus
+ *      SaveToFormat, which picks one of them by DUCI conversion ID, and
+ *      SaveToFormats / ExportPidData, which fan one decoded image out to
+ *      several of them at once. Output settings arrive per call as a
+ *      const ConvertOptions, so concurrent conversions can differ.
+ *      Palette-derived tables and PLTE/tRNS chunks come interned from
+ *      PaletteCache (pid_palette.h) instead of being rebuilt per file.
+ *      Temporary buffers (index plane, row and deflate buffers, write
+ *      blocks) are drawn from the per-thread ScratchArena (pid_arena.h),
+ *      z_streams are reused from the per-thread DeflatePool (pid_deflate.h).
+ *      Encode, trial and deflate time and the bytes produced go to
+ *      ConvertStats (pid_stats.h).
+ *      Any type with write(const void*, size_t) -> size_t and
+ *      seek_abs(int64_t) -> bool works: DelphiTStreamWrapper in the
+ *      DU5 plugin, MemoryStream in the command-line tools.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef PID_ENCODERS_H
+#define PID_ENCODERS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <zlib.h>
+#include "pid_arena.h"
+#include "pid_convert.h"
+#include "pid_decoder.h"
+#include "pid_deflate.h"
+#include "pid_palette.h"
+#include "pid_parallel.h"
+#include "pid_simd.h"
+#include "pid_stats.h"
+
+
+// ===================================================================
+// Helper: write PNG chunk straight to the stream (internal linkage)
+// ===================================================================
+template <class Stream>
+static bool write_PNG_Chunk(Stream &dst, const char *type, const unsigned char *data, unsigned int length)
+{
+    // Writes length (big-endian), type, data and CRC; the CRC runs over
+    // type and data as they are written
+    unsigned int len = _byteswap_ulong(length);
+    if (dst.write(&len, 4) != 4) return false;
+    if (dst.write(type, 4) != 4) return false;
+    unsigned int crc = crc32_png(reinterpret_cast<const unsigned char *>(type), 4);
+    if (data && length > 0)
+    {
+        if (dst.write(data, length) != length) return false;
+        crc = crc32_png(data, length, crc);
+    }
+    crc = _byteswap_ulong(crc);
+    return dst.write(&crc, 4) == 4;
+}
+
+// ===================================================================
+// Streaming IDAT writer
+// - Deflates input as it arrives into a fixed-size buffer and emits one
+//   IDAT chunk each time the buffer fills, so memory stays bounded by
+//   IdatChunkSize regardless of image size.
+// - The buffer comes from ScratchArena::local() (caller holds the Scope),
+//   the z_stream is leased from DeflatePool::local().
+// ===================================================================
+template <class Stream>
+class PngIdatWriter
+{
+public:
+    static constexpr std::size_t IdatChunkSize = 64 * 1024;
+
+    explicit PngIdatWriter(Stream &dst)
+        : fDst(dst), fOut(ScratchArena::local().alloc_array<unsigned char>(IdatChunkSize)) {}
+
+    ~PngIdatWriter()
+    {
+        if (fConsumed) ConvertStats::instance().deflated(fConsumed, fCompressed);
+    }
+
+    bool init(int level, int memLevel = 8, int strategy = Z_DEFAULT_STRATEGY)
+    {
+        if (!fLease.open(level, memLevel, strategy)) return false;
+        fZs = fLease.get();
+        fZs->next_out = fOut;
+        fZs->avail_out = static_cast<uInt>(IdatChunkSize);
+        return true;
+    }
+
+    // Feeds len bytes of filtered scanline data; set finish on the last call
+    bool write(const unsigned char *data, std::size_t len, bool finish = false)
+    {
+        fConsumed += len;
+        fZs->next_in = const_cast<Bytef *>(data);
+        fZs->avail_in = static_cast<uInt>(len);
+        const int flush = finish ? Z_FINISH : Z_NO_FLUSH;
+        for (;;)
+        {
+            int ret = deflate(fZs, flush);
+            if (ret == Z_STREAM_ERROR) { DBG_MSG("PngIdatWriter: deflate failed\n"); return false; }
+            if (fZs->avail_out == 0 && !emit()) return false;
+            if (finish ? ret == Z_STREAM_END : fZs->avail_in == 0) break;
+        }
+        return !finish || emit();
+    }
+
+    // Bytes written as IDAT chunks so far (length, type and CRC included)
+    std::size_t chunk_bytes() const { return fChunkBytes; }
+
+private:
+    // Writes the pending compressed bytes as one IDAT chunk
+    bool emit()
+    {
+        const std::size_t pending = IdatChunkSize - fZs->avail_out;
+        if (pending > 0 && !write_PNG_Chunk(fDst, "IDAT", fOut, static_cast<unsigned int>(pending)))
+        {
+            DBG_MSG("PngIdatWriter: failed writing IDAT\n");
+            return false;
+        }
+        if (pending > 0) { fCompressed += pending; fChunkBytes += pending + 12; }
+        fZs->next_out = fOut;
+        fZs->avail_out = static_cast<uInt>(IdatChunkSize);
+        return true;
+    }
+
+    Stream &fDst;
+    unsigned char *fOut;                // IdatChunkSize bytes from the scratch arena
+    DeflatePool::Lease fLease;
+    z_stream *fZs = nullptr;            // fLease.get() once init() succeeded
+    std::size_t fConsumed = 0;          // uncompressed bytes fed to deflate
+    std::size_t fCompressed = 0;        // deflate output emitted so far
+    std::size_t fChunkBytes = 0;        // see chunk_bytes()
+};
+
+// ===================================================================
+// PNG row filters
+// - None/Sub/Up/Average/Paeth are the PNG filter types 0..4; MinSum
+//   picks one of them per row by the minimum sum of absolute signed
+//   residuals (the heuristic suggested by the PNG specification).
+// ===================================================================
+enum class PngRowFilter : unsigned char
+{
+    None = 0,
+    Sub = 1,
+    Up = 2,
+    Average = 3,
+    Paeth = 4,
+    MinSum = 5
+};
+
+static inline unsigned char PaethPredictor(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return static_cast<unsigned char>(a);
+    if (pb <= pc) return static_cast<unsigned char>(b);
+    return static_cast<unsigned char>(c);
+}
+
+// Applies PNG filter type f (0..4) to cur (prev = row above, zeros for row 0)
+// - Bpp is a compile-time constant: the first pixel (no left neighbor)
+//   gets its own short loop, so the main loops have a fixed stride and no
+//   per-byte test, and the compiler can vectorize them.
+template <std::size_t Bpp>
+static void FilterRow(int f, const unsigned char *cur, const unsigned char *prev,
+                      std::size_t len, unsigned char *out)
+{
+    const std::size_t head = (std::min)(Bpp, len);
+    switch (f)
+    {
+    case 0:
+        std::memcpy(out, cur, len);
+        break;
+    case 1:
+        std::memcpy(out, cur, head);
+        for (std::size_t i = Bpp; i < len; ++i)
+            out[i] = static_cast<unsigned char>(cur[i] - cur[i - Bpp]);
+        break;
+    case 2:
+        for (std::size_t i = 0; i < len; ++i)
+            out[i] = static_cast<unsigned char>(cur[i] - prev[i]);
+        break;
+    case 3:
+        for (std::size_t i = 0; i < head; ++i)
+            out[i] = static_cast<unsigned char>(cur[i] - (prev[i] >> 1));
+        for (std::size_t i = Bpp; i < len; ++i)
+            out[i] = static_cast<unsigned char>(cur[i] - ((cur[i - Bpp] + prev[i]) >> 1));
+        break;
+    default:
+        // Paeth(0, b, 0) is b: the first pixel is predicted from above
+        for (std::size_t i = 0; i < head; ++i)
+            out[i] = static_cast<unsigned char>(cur[i] - prev[i]);
+        for (std::size_t i = Bpp; i < len; ++i)
+            out[i] = static_cast<unsigned char>(cur[i] - PaethPredictor(cur[i - Bpp], prev[i], prev[i - Bpp]));
+        break;
+    }
+}
+
+// Min-sum selection; out receives filter type + len bytes, cand is 5 * len bytes of scratch
+template <std::size_t Bpp>
+static void FilterRowMinSum(const unsigned char *cur, const unsigned char *prev,
+                            std::size_t len,
+                            unsigned char *out, unsigned char *cand)
+{
+    int best = 0;
+    std::uint64_t bestSum = ~0ULL;
+    for (int f = 0; f < 5; ++f)
+    {
+        unsigned char *c = cand + f * len;
+        FilterRow<Bpp>(f, cur, prev, len, c);
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < len; ++i) sum += c[i] < 128 ? c[i] : 256u - c[i];
+        if (sum < bestSum) { bestSum = sum; best = f; }
+    }
+    out[0] = static_cast<unsigned char>(best);
+    std::memcpy(out + 1, cand + best * len, len);
+}
+
+// ===================================================================
+// Index row sources for the PNG pipeline
+// - Any type with row(int y) -> const unsigned char* (width indices,
+//   nullptr on error) works. Rows are requested in increasing order
+//   within a pass; a new pass may start again from an earlier row.
+// - PixelPlaneRows serves a fully decoded index plane; PidScanlineDecoder
+//   (pid_decoder.h) decodes rows on demand; PidInvertedRows serves an
+//   inverted image from one decoded band of stored rows at a time.
+// ===================================================================
+struct PixelPlaneRows
+{
+    const unsigned char *base;
+    std::size_t width;
+
+    const unsigned char *row(int y) const { return base + static_cast<std::size_t>(y) * width; }
+};
+
+// -------------------------------------------------------------------
+// Top-down rows of an inverted .PID (rows stored bottom-up)
+// - The constructor indexes the stream in bands of stored rows
+//   (PidDecoder::index_rows, which also validates it: check valid()).
+// - row(y) decodes the band holding stored row H-1-y into a band buffer
+//   when that band is not loaded yet. Top-down requests walk the bands
+//   from last to first, so one pass decodes each band once.
+// - Memory is O(width * bandRows) plus the index; buffers come from the
+//   scratch arena (caller holds the Scope).
+// -------------------------------------------------------------------
+class PidInvertedRows
+{
+public:
+    static const std::size_t BandBytes = 64 * 1024;
+
+    PidInvertedRows(const unsigned char *data, std::size_t size, const PidInfo &info)
+        : fRows(data, size, info), fWidth(static_cast<std::size_t>(info.width)), fHeight(info.height)
+    {
+        const int bandRows = static_cast<int>((std::max)(BandBytes / (std::max)(fWidth, static_cast<std::size_t>(1)),
+                                                         static_cast<std::size_t>(1)));
+        fValid = PidDecoder::index_rows(data, size, info, bandRows, fIndex);
+        fBand = ScratchArena::local().alloc_array<unsigned char>(fWidth * static_cast<std::size_t>(fIndex.bandRows));
+    }
+
+    bool valid() const { return fValid; }
+    int band_rows() const { return fIndex.bandRows; }
+
+    const unsigned char *row(int y)
+    {
+        const int stored = fHeight - 1 - y;
+        const int band = stored / fIndex.bandRows;
+        if (band != fLoaded)
+        {
+            fLoaded = -1;
+            fRows.seek(fIndex.bands[static_cast<std::size_t>(band)]);
+            const int count = (std::min)(fIndex.bandRows, fHeight - band * fIndex.bandRows);
+            for (int r = 0; r < count; ++r)
+                if (!fRows.read_row(fBand + static_cast<std::size_t>(r) * fWidth)) return nullptr;
+            fLoaded = band;
+        }
+        return fBand + static_cast<std::size_t>(stored - band * fIndex.bandRows) * fWidth;
+    }
+
+private:
+    PidScanlineDecoder fRows;
+    PidRowIndex fIndex;
+    std::size_t fWidth;
+    int fHeight;
+    unsigned char *fBand = nullptr;
+    int fLoaded = -1;
+    bool fValid = false;
+};
+
+// ===================================================================
+// Scanline source for SaveToPNG
+// - Produces filtered scanlines (filter byte + data) for any row, keeping
+//   only the current and previous unfiltered rows (O(width) memory).
+// - Rows must be requested in increasing order after begin(y0).
+// - Row buffers come from ScratchArena::local() (caller holds the Scope).
+// - The bit depth is a template constant (one class per PNGMode, picked
+//   by SaveToPNG once per file): row expansion and filtering compile to
+//   fixed-stride loops with no mode test inside.
+// ===================================================================
+template <class Rows, PNGMode Mode>
+class PngScanlines
+{
+public:
+    static constexpr std::size_t Bpp = (Mode == PNGMode::PNG_8) ? 1 : (Mode == PNGMode::PNG_24) ? 3 : 4;
+
+    PngScanlines(Rows &rows, int width, const PaletteArtifacts &palette)
+        : fSource(rows), fWidth(static_cast<std::size_t>(width)), fTable(palette.rgba)
+    {
+        fLen = fWidth * Bpp;
+        ScratchArena &arena = ScratchArena::local();
+        fRows = arena.alloc_array<unsigned char>(2 * fLen);
+        fLine = arena.alloc_array<unsigned char>(fLen + 1);
+        fCand = arena.alloc_array<unsigned char>(5 * fLen);
+    }
+
+    std::size_t size() const { return fLen + 1; }
+
+    // Prepares the "row above" for a sequence starting at y0
+    bool begin(int y0)
+    {
+        if (y0 > 0) return expand(y0 - 1) != nullptr;
+        std::memset(slot(-1), 0, fLen);
+        return true;
+    }
+
+    // Returns the filtered scanline for row y (nullptr if the source fails)
+    const unsigned char *row(int y, PngRowFilter filter)
+    {
+        const unsigned char *cur = expand(y);
+        if (!cur) return nullptr;
+        const unsigned char *prev = slot(y - 1);
+        if (filter == PngRowFilter::MinSum)
+        {
+            FilterRowMinSum<Bpp>(cur, prev, fLen, fLine, fCand);
+        }
+        else
+        {
+            fLine[0] = static_cast<unsigned char>(filter);
+            FilterRow<Bpp>(static_cast<int>(filter), cur, prev, fLen, fLine + 1);
+        }
+        return fLine;
+    }
+
+private:
+    unsigned char *slot(int y) { return fRows + (y & 1) * fLen; }
+
+    const unsigned char *expand(int y)
+    {
+        const unsigned char *src = fSource.row(y);
+        if (!src) return nullptr;
+        unsigned char *dst = slot(y);
+        if constexpr (Mode == PNGMode::PNG_8)       std::memcpy(dst, src, fWidth);
+        else if constexpr (Mode == PNGMode::PNG_24) ExpandIndices24(src, fWidth, fTable, dst);
+        else                                        ExpandIndices32(src, fWidth, fTable, dst);
+        return dst;
+    }
+
+    Rows &fSource;
+    std::size_t fWidth;
+    std::size_t fLen = 0;
+    const std::uint32_t *fTable;        // interned RGBA expansion table (24/32bpp)
+    unsigned char *fRows = nullptr;     // current + previous unfiltered row
+    unsigned char *fLine = nullptr;     // filtered scanline handed to deflate
+    unsigned char *fCand = nullptr;     // MinSum candidates
+};
+
+// ===================================================================
+// Compression presets
+// - Fast: zlib level 1, filter 0, no trials.
+// - Balanced: default level. 8bpp keeps filter 0 (what the PNG spec
+//   recommends for paletted images). 24/32bpp chooses between filter 0
+//   and per-row MinSum with one cheap check: both are deflated at level 1
+//   over a sample of row strips (the whole image if it is short), since
+//   MinSum often loses to filter 0 on palette-expanded sprites.
+// - Smallest: filter/strategy choice by trial compression over the whole
+//   image at level 9, with every filter as a candidate.
+// - Trials deflate into a scratch buffer (output discarded) and the
+//   smallest result wins.
+// ===================================================================
+struct PngEncodeParams
+{
+    int level;
+    int memLevel;
+    int strategy;
+    PngRowFilter filter;
+};
+
+// Deflated size of rows [y0, y1) of each strip, using the given filter/strategy
+template <class Lines>
+static std::size_t PngTrialSize(Lines &lines, const std::vector<std::pair<int, int>> &strips,
+                                PngRowFilter filter, int level, int memLevel, int strategy)
+{
+    DeflatePool::Lease lease;
+    if (!lease.open(level, memLevel, strategy)) return ~static_cast<std::size_t>(0);
+    z_stream &zs = *lease.get();
+    unsigned char scratch[16 * 1024];
+    std::size_t total = 0;
+    for (std::size_t s = 0; s < strips.size(); ++s)
+    {
+        if (!lines.begin(strips[s].first)) return ~static_cast<std::size_t>(0);
+        for (int y = strips[s].first; y < strips[s].second; ++y)
+        {
+            const bool finish = (s + 1 == strips.size() && y + 1 == strips[s].second);
+            const unsigned char *line = lines.row(y, filter);
+            if (!line) return ~static_cast<std::size_t>(0);
+            zs.next_in = const_cast<Bytef *>(line);
+            zs.avail_in = static_cast<uInt>(lines.size());
+            int ret;
+            do
+            {
+                zs.next_out = scratch;
+                zs.avail_out = sizeof(scratch);
+                ret = deflate(&zs, finish ? Z_FINISH : Z_NO_FLUSH);
+                total += sizeof(scratch) - zs.avail_out;
+            } while (zs.avail_out == 0 || (finish && ret != Z_STREAM_END && ret != Z_STREAM_ERROR));
+        }
+    }
+    return total;
+}
+
+template <class Lines>
+static PngEncodeParams ChoosePngParams(Lines &lines, int height, PNGMode mode, PNGCompression preset)
+{
+    const bool paletted = (mode == PNGMode::PNG_8);
+    if (preset == PNGCompression::Fast)
+        return { 1, 8, Z_DEFAULT_STRATEGY, PngRowFilter::None };
+
+    if (preset == PNGCompression::Balanced)
+    {
+        PngEncodeParams params = { Z_DEFAULT_COMPRESSION, 8, Z_DEFAULT_STRATEGY, PngRowFilter::None };
+        if (paletted) return params;
+
+        // Sample: the whole image up to StripRows * MaxStrips rows, otherwise
+        // MaxStrips strips of StripRows consecutive rows spread over it
+        ConvertStats::Timer timer(ConvertStats::StageTrials);
+        const int StripRows = 8, MaxStrips = 4;
+        std::vector<std::pair<int, int>> strips;
+        if (height <= StripRows * MaxStrips)
+        {
+            strips.push_back(std::make_pair(0, height));
+        }
+        else
+        {
+            for (int i = 0; i < MaxStrips; ++i)
+            {
+                const int y0 = static_cast<int>(static_cast<long long>(height - StripRows) * i / (MaxStrips - 1));
+                strips.push_back(std::make_pair(y0, y0 + StripRows));
+            }
+        }
+        const std::size_t none = PngTrialSize(lines, strips, PngRowFilter::None, 1, 8, Z_DEFAULT_STRATEGY);
+        const std::size_t minSum = PngTrialSize(lines, strips, PngRowFilter::MinSum, 1, 8, Z_DEFAULT_STRATEGY);
+        if (minSum < none) params.filter = PngRowFilter::MinSum;
+        return params;
+    }
+
+    ConvertStats::Timer timer(ConvertStats::StageTrials);
+    PngEncodeParams best = { 9, 9, Z_DEFAULT_STRATEGY, PngRowFilter::None };
+    const std::vector<std::pair<int, int>> strips(1, std::make_pair(0, height));
+
+    struct Candidate { PngRowFilter filter; int strategy; };
+    static const Candidate paletteCandidates[] = {
+        { PngRowFilter::None, Z_DEFAULT_STRATEGY }, { PngRowFilter::None, Z_RLE }
+    };
+    static const Candidate colorCandidates[] = {
+        { PngRowFilter::None, Z_DEFAULT_STRATEGY }, { PngRowFilter::Sub, Z_DEFAULT_STRATEGY },
+        { PngRowFilter::Up, Z_DEFAULT_STRATEGY }, { PngRowFilter::Average, Z_DEFAULT_STRATEGY },
+        { PngRowFilter::Paeth, Z_DEFAULT_STRATEGY }, { PngRowFilter::MinSum, Z_DEFAULT_STRATEGY }
+    };
+    const Candidate *cands = paletted ? paletteCandidates : colorCandidates;
+    const std::size_t count = paletted ? sizeof(paletteCandidates) / sizeof(paletteCandidates[0]) : sizeof(colorCandidates) / sizeof(colorCandidates[0]);
+
+    std::size_t bestSize = ~static_cast<std::size_t>(0);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::size_t size = PngTrialSize(lines, strips, cands[i].filter, best.level, best.memLevel, cands[i].strategy);
+        if (size < bestSize)
+        {
+            bestSize = size;
+            best.filter = cands[i].filter;
+            best.strategy = cands[i].strategy;
+        }
+    }
+    return best;
+}
+
+// ===================================================================
+// Little-endian field helpers for building headers in memory
+// ===================================================================
+static inline unsigned char *PutLE16(unsigned char *p, std::uint16_t v)
+{
+    p[0] = static_cast<unsigned char>(v & 0xFF);
+    p[1] = static_cast<unsigned char>((v >> 8) & 0xFF);
+    return p + 2;
+}
+
+static inline unsigned char *PutLE32(unsigned char *p, std::uint32_t v)
+{
+    p[0] = static_cast<unsigned char>(v & 0xFF);
+    p[1] = static_cast<unsigned char>((v >> 8) & 0xFF);
+    p[2] = static_cast<unsigned char>((v >> 16) & 0xFF);
+    p[3] = static_cast<unsigned char>((v >> 24) & 0xFF);
+    return p + 4;
+}
+
+// Target size of one coalesced pixel write (several rows per dst.write)
+static const std::size_t EncoderWriteChunk = 256 * 1024;
+
+// ===================================================================
+// Save as BMP 24bpp (true-color, BGR)
+// - Header is built field by field in little-endian in a stack buffer
+//   (no struct padding issues) and sent with a single write.
+// - Pixels go through the interned BGR table (index 0 already black
+//   when the palette is transparent).
+// - Rows are expanded into a multi-row block from the scratch arena and
+//   written in large chunks.
+// ===================================================================
+template <class Stream>
+static int SaveToBMP(Stream &dst,
+              const unsigned char *pixels,
+              int width, int height,
+              const PaletteArtifacts &palette)
+{
+    // Image parameters
+    const int bpp = 24;                            // we write 24bpp BGR (true-color)
+    const int rowSize = ((width * 3 + 3) & ~3);    // align to 4 bytes
+    const int imageSize = rowSize * height;
+    const uint32_t infoSize = 40;                  // BITMAPINFOHEADER size
+    const uint32_t paletteBytes = 0;               // no palette for 24bpp in BMP DIB
+    const uint32_t dataOffset = 14 + infoSize + static_cast<uint32_t>(paletteBytes);
+    const uint32_t fileSize = dataOffset + static_cast<uint32_t>(imageSize);
+    ConvertStats::Timer timer(ConvertStats::StageEncode);
+
+    // --- BITMAPFILEHEADER (14 bytes) + BITMAPINFOHEADER (40 bytes) ---
+    unsigned char header[54];
+    unsigned char *p = header;
+    *p++ = 'B'; *p++ = 'M';                                 // signature
+    p = PutLE32(p, fileSize);
+    p = PutLE16(p, 0);                                      // reserved1
+    p = PutLE16(p, 0);                                      // reserved2
+    p = PutLE32(p, dataOffset);
+    p = PutLE32(p, infoSize);
+    p = PutLE32(p, static_cast<uint32_t>(width));
+    p = PutLE32(p, static_cast<uint32_t>(height));          // height positive => bottom-up
+    p = PutLE16(p, 1);                                      // planes
+    p = PutLE16(p, static_cast<uint16_t>(bpp));
+    p = PutLE32(p, 0);                                      // BI_RGB
+    p = PutLE32(p, static_cast<uint32_t>(imageSize));
+    p = PutLE32(p, 0);                                      // xPelsPerMeter
+    p = PutLE32(p, 0);                                      // yPelsPerMeter
+    p = PutLE32(p, 0);                                      // clrUsed
+    p = PutLE32(p, 0);                                      // clrImportant
+    if (dst.write(header, sizeof(header)) != sizeof(header)) { DBG_MSG("SaveToBMP: failed writing header\n"); return 1; }
+
+    // --- Pixels (BGR, bottom-up: write from bottom row to top) ---
+    const std::uint32_t *table = palette.bgr;
+    const int rowsPerWrite = static_cast<int>((std::max)(static_cast<std::size_t>(1), EncoderWriteChunk / rowSize));
+    ScratchArena::Scope scratch;
+    unsigned char *block = scratch.arena().alloc_array<unsigned char>(
+        static_cast<std::size_t>(rowSize) * (std::min)(rowsPerWrite, height), true);
+    for (int y = height - 1; y >= 0; )
+    {
+        const int rows = (std::min)(rowsPerWrite, y + 1);
+        for (int r = 0; r < rows; ++r, --y)
+        {
+            // fill BGR row (no alpha); padding stays 0 from initialization
+            ExpandIndices24(pixels + static_cast<std::size_t>(y) * width, width, table,
+                            block + static_cast<std::size_t>(r) * rowSize);
+        }
+        const std::size_t bytes = static_cast<std::size_t>(rows) * rowSize;
+        if (dst.write(block, bytes) != bytes)
+        {
+            DBG_MSG("SaveToBMP: failed writing pixel rows above %d\n", y);
+            return 1;
+        }
+    }
+
+    // Reset stream position to start (host expects this)
+    if (!dst.seek_abs(0)) { DBG_MSG("SaveToBMP: seek_abs(0) failed\n"); return 1; }
+    ConvertStats::instance().encoded(static_cast<std::uint64_t>(width) * height, fileSize);
+
+#ifdef _DEBUG
+    char dbgBuf[256];
+    _snprintf_s(dbgBuf, sizeof(dbgBuf), _TRUNCATE, "SaveToBMP: OK (24bpp, %dx%d, fileSize=%u)\n", width, height, fileSize);
+    DBG_MSG(dbgBuf);
+#endif
+
+    return 0; // success
+}
+
+// ===================================================================
+// TGA header (18 bytes) + colormap (256 * 3 = B,G,R) in one buffer
+// - Always 8bpp colormapped with a 24bpp BGR palette; transparency is
+//   ignored (index 0 drawn as black), top-left origin.
+// - Fields are written one by one in little-endian, so there are no
+//   padding/align issues between compilers.
+// ===================================================================
+static const std::size_t TGAHeaderSize = 18 + 768;
+
+static void BuildTGAHeader(unsigned char *out, int width, int height,
+                           const PaletteArtifacts &palette,
+                           uint8_t imageType)
+{
+    // Parameters
+    const uint8_t idLength = 0;
+    const uint8_t colorMapType = 1;    // palette present
+    const uint16_t colorMapStart = 0;
+    const uint16_t colorMapLength = 256;
+    const uint8_t colorMapBits = 24;   // 3 bytes per palette entry (B,G,R)
+    const uint16_t xOrigin = 0;
+    const uint16_t yOrigin = 0;
+    const uint8_t pixelDepth = 8;      // 8bpp indexed
+    const uint8_t imageDesc = 0x20;    // bit5 = top-left origin
+
+    unsigned char *p = out;
+    *p++ = idLength;
+    *p++ = colorMapType;
+    *p++ = imageType;
+    p = PutLE16(p, colorMapStart);
+    p = PutLE16(p, colorMapLength);
+    *p++ = colorMapBits;
+    p = PutLE16(p, xOrigin);
+    p = PutLE16(p, yOrigin);
+    p = PutLE16(p, static_cast<uint16_t>(width));
+    p = PutLE16(p, static_cast<uint16_t>(height));
+    *p++ = pixelDepth;
+    *p++ = imageDesc;
+    std::memcpy(p, palette.tgaColormap, sizeof(palette.tgaColormap)); // transparent -> black
+}
+
+// ===================================================================
+// Save as TGA (type 1, colormapped, uncompressed)
+// Scope: internal (static)
+// ===================================================================
+template <class Stream>
+static int SaveToTGA(Stream &dst,
+              const unsigned char *pixels,
+              int width, int height,
+              const PaletteArtifacts &palette)
+{
+    ConvertStats::Timer timer(ConvertStats::StageEncode);
+    unsigned char header[TGAHeaderSize];
+    BuildTGAHeader(header, width, height, palette, 1);
+    if (dst.write(header, sizeof(header)) != sizeof(header)) { DBG_MSG("SaveToTGA: failed writing header\n"); return 1; }
+
+    // --- Write pixel indices ---
+    // imageDesc = 0x20 => top-left origin, so the top-down index plane is
+    // already in file order; send it in large contiguous blocks
+    const std::size_t total = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    for (std::size_t off = 0; off < total; )
+    {
+        const std::size_t bytes = (std::min)(EncoderWriteChunk, total - off);
+        if (dst.write(pixels + off, bytes) != bytes)
+        {
+            DBG_MSG("SaveToTGA: failed writing pixel data at %zu\n", off);
+            return 1;
+        }
+        off += bytes;
+    }
+
+    // Reset stream position to start (host expects this)
+    if (!dst.seek_abs(0)) { DBG_MSG("SaveToTGA: seek_abs(0) failed\n"); return 1; }
+    ConvertStats::instance().encoded(total, sizeof(header) + total);
+
+#ifdef _DEBUG
+    // Direct DBG_MSG (formatted buffer, independent of macro)
+    char dbgBuf[128];
+    _snprintf_s(dbgBuf, sizeof(dbgBuf), _TRUNCATE, "SaveToTGA: OK (8bpp paletted, %dx%d)\n", width, height);
+    DBG_MSG(dbgBuf);
+#endif
+
+    return 0; // success
+}
+
+// ===================================================================
+// TGA RLE packets for one row of indices
+// - Run packet:  0x80 | (n-1), one index, n = 2..128 repeats
+// - Raw packet:  (n-1), n literal indices, n = 1..128
+// - Runs of 3+ always become run packets; a run of 2 only when no raw
+//   packet is open (2 bytes either way, but it would split the raw one).
+// - Packets never cross rows. Returns bytes written; worst case is
+//   width + ceil(width / 128).
+// ===================================================================
+static std::size_t EncodeTGARow(const unsigned char *row, std::size_t width, unsigned char *out)
+{
+    unsigned char *p = out;
+    std::size_t litStart = 0, litLen = 0;
+    auto flush_literals = [&]() {
+        while (litLen > 0)
+        {
+            const std::size_t n = (std::min)(litLen, static_cast<std::size_t>(128));
+            *p++ = static_cast<unsigned char>(n - 1);
+            std::memcpy(p, row + litStart, n);
+            p += n; litStart += n; litLen -= n;
+        }
+    };
+
+    std::size_t x = 0;
+    while (x < width)
+    {
+        const unsigned char v = row[x];
+        std::size_t run = 1;
+        while (x + run < width && run < 128 && row[x + run] == v) ++run;
+
+        if (run >= 3 || (run == 2 && litLen == 0))
+        {
+            flush_literals();
+            *p++ = static_cast<unsigned char>(0x80 | (run - 1));
+            *p++ = v;
+            x += run;
+            litStart = x;
+        }
+        else
+        {
+            if (litLen == 0) litStart = x;
+            litLen += run;
+            x += run;
+        }
+    }
+    flush_literals();
+    return static_cast<std::size_t>(p - out);
+}
+
+// ===================================================================
+// Save as TGA RLE (type 9, colormapped, run-length encoded)
+// - Same header/colormap as SaveToTGA; rows encoded into a block from the
+//   scratch arena and written in large chunks.
+// Scope: internal (static)
+// ===================================================================
+template <class Stream>
+static int SaveToTGARLE(Stream &dst,
+              const unsigned char *pixels,
+              int width, int height,
+              const PaletteArtifacts &palette)
+{
+    ConvertStats::Timer timer(ConvertStats::StageEncode);
+    unsigned char header[TGAHeaderSize];
+    BuildTGAHeader(header, width, height, palette, 9);
+    if (dst.write(header, sizeof(header)) != sizeof(header)) { DBG_MSG("SaveToTGARLE: failed writing header\n"); return 1; }
+
+    const std::size_t w = static_cast<std::size_t>(width);
+    const std::size_t worstRow = w + (w + 127) / 128;
+    const std::size_t blockSize = (std::max)(EncoderWriteChunk, worstRow);
+    ScratchArena::Scope scratch;
+    unsigned char *block = scratch.arena().alloc_array<unsigned char>(blockSize);
+    std::size_t used = 0, written = sizeof(header);
+    for (int y = 0; y < height; ++y)
+    {
+        if (blockSize - used < worstRow)
+        {
+            if (dst.write(block, used) != used) { DBG_MSG("SaveToTGARLE: failed writing rows before %d\n", y); return 1; }
+            written += used;
+            used = 0;
+        }
+        used += EncodeTGARow(pixels + static_cast<std::size_t>(y) * w, w, block + used);
+    }
+    if (used > 0 && dst.write(block, used) != used) { DBG_MSG("SaveToTGARLE: failed writing last rows\n"); return 1; }
+
+    // Reset stream position to start (host expects this)
+    if (!dst.seek_abs(0)) { DBG_MSG("SaveToTGARLE: seek_abs(0) failed\n"); return 1; }
+    ConvertStats::instance().encoded(static_cast<std::uint64_t>(w) * height, written + used);
+
+#ifdef _DEBUG
+    char dbgBuf[128];
+    _snprintf_s(dbgBuf, sizeof(dbgBuf), _TRUNCATE, "SaveToTGARLE: OK (8bpp paletted RLE, %dx%d)\n", width, height);
+    DBG_MSG(dbgBuf);
+#endif
+
+    return 0; // success
+}
+
+// ===================================================================
+// RAW8 + PAL (engine passthrough)
+// - RawIndexHeader, the interned RGBA table as the palette, then the
+//   index plane exactly as decoded: no per-pixel work at all.
+// - BuildRawIndexHead fills the first RawIndexHeadSize bytes, so a
+//   caller that decodes straight into its own output buffer (the CLI
+//   maps the output file) can write the file without this encoder.
+// ===================================================================
+static const std::size_t RawIndexHeadSize = sizeof(RawIndexHeader) + 1024;
+
+static void BuildRawIndexHead(unsigned char *out, const PIDHeader &header, const PaletteArtifacts &palette)
+{
+    RawIndexHeader raw = {};
+    std::memcpy(raw.Magic, "RAW8", 4);
+    raw.Version = 1;
+    raw.HeaderSize = static_cast<unsigned short>(sizeof(RawIndexHeader));
+    raw.Width = header.Width;
+    raw.Height = header.Height;
+    raw.Flags = (header.Flags & ~PID_FLAG_TRANSPARENT) | (palette.transparent ? PID_FLAG_TRANSPARENT : 0);
+    std::memcpy(raw.U, header.U, sizeof(raw.U));
+    raw.PixelOffset = static_cast<unsigned int>(RawIndexHeadSize);
+    std::memcpy(out, &raw, sizeof(raw));
+    std::memcpy(out + sizeof(raw), palette.rgba, sizeof(palette.rgba)); // R,G,B,A byte order
+}
+
+template <class Stream>
+static int SaveToRAW8(Stream &dst,
+                      const unsigned char *pixels,
+                      const PIDHeader &header,
+                      const PaletteArtifacts &palette)
+{
+    ConvertStats::Timer timer(ConvertStats::StageEncode);
+    unsigned char head[RawIndexHeadSize];
+    BuildRawIndexHead(head, header, palette);
+    if (dst.write(head, sizeof(head)) != sizeof(head)) { DBG_MSG("SaveToRAW8: failed writing header\n"); return 1; }
+
+    const std::size_t total = static_cast<std::size_t>(header.Width) * static_cast<std::size_t>(header.Height);
+    for (std::size_t off = 0; off < total; )
+    {
+        const std::size_t bytes = (std::min)(EncoderWriteChunk, total - off);
+        if (dst.write(pixels + off, bytes) != bytes)
+        {
+            DBG_MSG("SaveToRAW8: failed writing pixel data at %zu\n", off);
+            return 1;
+        }
+        off += bytes;
+    }
+
+    if (!dst.seek_abs(0)) { DBG_MSG("SaveToRAW8: seek_abs(0) failed\n"); return 1; }
+    ConvertStats::instance().encoded(total, sizeof(head) + total);
+    DBG_MSG("SaveToRAW8: OK (%dx%d)\n", header.Width, header.Height);
+    return 0;
+}
+
+// =========================================================================================
+// PNG signature, IHDR and (8bpp) PLTE / tRNS
+// - Returns the number of bytes written, 0 on write error.
+// =========================================================================================
+template <class Stream>
+static std::size_t WritePngHead(Stream &dst, int width, int height, PNGMode mode, const PaletteArtifacts &palette)
+{
+    const unsigned char signature[] = { 0x89,'P','N','G',0x0D,0x0A,0x1A,0x0A };
+    if (dst.write(signature, sizeof(signature)) != sizeof(signature)) { DBG_MSG("SaveToPNG: failed writing signature\n"); return 0; }
+
+    // --- IHDR ---
+    struct { unsigned int w, h; unsigned char bd, ct, cm, f, i; } ihdr = {};
+    ihdr.w = _byteswap_ulong(static_cast<unsigned int>(width));
+    ihdr.h = _byteswap_ulong(static_cast<unsigned int>(height));
+    ihdr.bd = 8; // always 8 bits per channel
+    ihdr.cm = 0; ihdr.f = 0; ihdr.i = 0;
+
+    if (mode == PNGMode::PNG_8)      ihdr.ct = 3; // indexed-color
+    else if (mode == PNGMode::PNG_24) ihdr.ct = 2; // true-color RGB
+    else                              ihdr.ct = 6; // true-color RGBA
+
+    if (!write_PNG_Chunk(dst, "IHDR", reinterpret_cast<unsigned char *>(&ihdr), 13)) { DBG_MSG("SaveToPNG: failed writing IHDR\n"); return 0; }
+    std::size_t written = sizeof(signature) + 25;
+
+    // --- PLTE / tRNS only for 8bpp ---
+    // (complete chunks, CRCs included, come precomputed with the palette)
+    if (mode == PNGMode::PNG_8)
+    {
+        if (dst.write(palette.plteChunk, sizeof(palette.plteChunk)) != sizeof(palette.plteChunk)) { DBG_MSG("SaveToPNG: failed writing PLTE\n"); return 0; }
+        written += sizeof(palette.plteChunk);
+
+        if (palette.transparent)
+        {
+            if (dst.write(palette.trnsChunk, sizeof(palette.trnsChunk)) != sizeof(palette.trnsChunk)) { DBG_MSG("SaveToPNG: failed writing tRNS\n"); return 0; }
+            written += sizeof(palette.trnsChunk);
+        }
+    }
+    return written;
+}
+
+// =========================================================================================
+// Save as PNG (supports 8bpp paletted, 24bpp true-color and 32bpp RGBA)
+// - Index rows are pulled from a row source (see PixelPlaneRows), so the
+//   same code serves a decoded image and the pipelined scanline decoder.
+// - Bit depth and compression preset come from options, nothing global.
+//   SaveToPNGRows picks the SaveToPNGRowsAs<Mode> instance once per file.
+// =========================================================================================
+template <PNGMode Mode, class Stream, class Rows>
+static int SaveToPNGRowsAs(Stream &dst,
+                           Rows &rows,
+                           int width, int height,
+                           const PaletteArtifacts &palette,
+                           const ConvertOptions &options)
+{
+    ConvertStats::Timer timer(ConvertStats::StageEncode);
+    const std::size_t head = WritePngHead(dst, width, height, Mode, palette);
+    if (head == 0) return 1;
+
+    // --- IDAT (filtered and deflated one row at a time) ---
+    ScratchArena::Scope scratch;
+    PngScanlines<Rows, Mode> lines(rows, width, palette);
+    const PngEncodeParams params = ChoosePngParams(lines, height, Mode, options.pngCompression);
+    PngIdatWriter<Stream> idat(dst);
+    if (!idat.init(params.level, params.memLevel, params.strategy)) { DBG_MSG("SaveToPNG: deflateInit failed\n"); return 1; }
+
+    ConvertStats::Timer idatTimer(ConvertStats::StageIdat);
+    if (Mode == PNGMode::PNG_8 && params.filter == PngRowFilter::None)
+    {
+        // Indices go to deflate directly from the row source, no row copy
+        const unsigned char filterNone = 0;
+        for (int y = 0; y < height; ++y)
+        {
+            const bool last = (y == height - 1);
+            const unsigned char *src = rows.row(y);
+            if (!src) { DBG_MSG("SaveToPNG: row source failed at row %d\n", y); return 1; }
+            if (!idat.write(&filterNone, 1) || !idat.write(src, width, last))
+                return 1;
+        }
+    }
+    else
+    {
+        // Rows expanded and filtered one at a time
+        if (!lines.begin(0)) return 1;
+        for (int y = 0; y < height; ++y)
+        {
+            const unsigned char *line = lines.row(y, params.filter);
+            if (!line) { DBG_MSG("SaveToPNG: row source failed at row %d\n", y); return 1; }
+            if (!idat.write(line, lines.size(), y == height - 1)) return 1;
+        }
+    }
+
+    if (!write_PNG_Chunk(dst, "IEND", nullptr, 0)) { DBG_MSG("SaveToPNG: failed writing IEND\n"); return 1; }
+
+    // signature + IHDR + PLTE/tRNS + IDAT + IEND
+    ConvertStats::instance().encoded(static_cast<std::uint64_t>(width) * height, head + idat.chunk_bytes() + 12);
+
+#ifdef _DEBUG
+    char dbgBuf[256];
+    const char *modeStr = (Mode == PNGMode::PNG_8) ? "8bpp paletted" :
+        (Mode == PNGMode::PNG_24) ? "24bpp true-color" :
+        "32bpp RGBA";
+    _snprintf_s(dbgBuf, sizeof(dbgBuf), _TRUNCATE,
+                "SaveToPNG: OK (%s, %dx%d)\n", modeStr, width, height);
+    DBG_MSG(dbgBuf);
+#endif // _DEBUG
+
+    return 0;
+}
+
+template <class Stream, class Rows>
+static int SaveToPNGRows(Stream &dst,
+                         Rows &rows,
+                         int width, int height,
+                         const PaletteArtifacts &palette,
+                         const ConvertOptions &options)
+{
+    switch (options.pngMode)
+    {
+    case PNGMode::PNG_24: return SaveToPNGRowsAs<PNGMode::PNG_24>(dst, rows, width, height, palette, options);
+    case PNGMode::PNG_32: return SaveToPNGRowsAs<PNGMode::PNG_32>(dst, rows, width, height, palette, options);
+    default:              return SaveToPNGRowsAs<PNGMode::PNG_8>(dst, rows, width, height, palette, options);
+    }
+}
+
+// =========================================================================================
+// Save as PNG from a full index plane, row bands deflated in parallel
+// - The zlib stream is cut into bands of about PngBandBytes of filtered
+//   scanlines (a fixed size, so the file does not depend on the core
+//   count). Each band is deflated on its own z_stream, primed with the
+//   last 32K of the band before it as preset dictionary, and ends with
+//   Z_SYNC_FLUSH (the last one with Z_FINISH), so the bands concatenate
+//   into one valid stream, the way pigz does it.
+// - Bands are deflated one window (one band per thread) at a time and
+//   written in order before the next window starts, so at most that many
+//   compressed bands are held in memory.
+// - The zlib header is kept from band 0 only, the per-band Adler-32
+//   values are merged with adler32_combine into the trailer.
+// - Filter and strategy are chosen once up front, like the serial path.
+// =========================================================================================
+static const std::size_t PngBandBytes = 512 * 1024;
+
+template <PNGMode Mode, class Stream>
+static int SaveToPNGBandsAs(Stream &dst,
+                            const unsigned char *pixels,
+                            int width, int height,
+                            const PaletteArtifacts &palette,
+                            const ConvertOptions &options)
+{
+    ConvertStats::Timer timer(ConvertStats::StageEncode);
+    const std::size_t head = WritePngHead(dst, width, height, Mode, palette);
+    if (head == 0) return 1;
+
+    PngEncodeParams params;
+    std::size_t lineSize;
+    {
+        ScratchArena::Scope scratch;
+        PixelPlaneRows rows = { pixels, static_cast<std::size_t>(width) };
+        PngScanlines<PixelPlaneRows, Mode> lines(rows, width, palette);
+        params = ChoosePngParams(lines, height, Mode, options.pngCompression);
+        lineSize = lines.size();
+    }
+
+    struct Band
+    {
+        std::vector<unsigned char> data;    // raw deflate data (band 0: with zlib header)
+        uLong adler = 0;                    // Adler-32 of the band's scanlines
+    };
+    const int bandRows = static_cast<int>((std::max)(PngBandBytes / lineSize, static_cast<std::size_t>(1)));
+    const std::size_t bandCount = static_cast<std::size_t>((height + bandRows - 1) / bandRows);
+    const std::size_t windowSize = (std::min)(static_cast<std::size_t>(ResolveWorkers(options.workers)), bandCount);
+    std::vector<Band> window(windowSize);
+
+    // Deflates band b into band (one thread per call)
+    auto deflateBand = [&](std::size_t b, Band &band) -> bool {
+        ScratchArena::Scope local;
+        PixelPlaneRows rows = { pixels, static_cast<std::size_t>(width) };
+        PngScanlines<PixelPlaneRows, Mode> lines(rows, width, palette);
+        const int y0 = static_cast<int>(b) * bandRows;
+        const int y1 = (std::min)(y0 + bandRows, height);
+        const bool last = (b + 1 == bandCount);
+
+        DeflatePool::Lease lease;
+        if (!lease.open(params.level, params.memLevel, params.strategy)) return false;
+        z_stream &zs = *lease.get();
+
+        // Preset dictionary: the filtered rows just above the band
+        const std::size_t dictWindow = 32 * 1024;
+        const int dictRows = (std::min)(y0, static_cast<int>((dictWindow + lineSize - 1) / lineSize));
+        if (!lines.begin(y0 - dictRows)) return false;
+        if (dictRows > 0)
+        {
+            unsigned char *dict = local.arena().alloc_array<unsigned char>(dictRows * lineSize);
+            for (int y = y0 - dictRows; y < y0; ++y)
+            {
+                const unsigned char *line = lines.row(y, params.filter);
+                if (!line) return false;
+                std::memcpy(dict + (y - (y0 - dictRows)) * lineSize, line, lineSize);
+            }
+            const std::size_t dictSize = (std::min)(dictRows * lineSize, dictWindow);
+            if (deflateSetDictionary(&zs, dict + dictRows * lineSize - dictSize, static_cast<uInt>(dictSize)) != Z_OK) return false;
+        }
+
+        band.data.resize(deflateBound(&zs, static_cast<uLong>((y1 - y0) * lineSize)) + 16);
+        zs.next_out = band.data.data();
+        zs.avail_out = static_cast<uInt>(band.data.size());
+        for (int y = y0; y < y1; ++y)
+        {
+            const unsigned char *line = lines.row(y, params.filter);
+            if (!line) return false;
+            zs.next_in = const_cast<Bytef *>(line);
+            zs.avail_in = static_cast<uInt>(lineSize);
+            const int flush = (y + 1 < y1) ? Z_NO_FLUSH : last ? Z_FINISH : Z_SYNC_FLUSH;
+            for (;;)
+            {
+                const int ret = deflate(&zs, flush);
+                if (ret == Z_STREAM_ERROR) return false;
+                const bool done = (flush == Z_FINISH) ? ret == Z_STREAM_END : (zs.avail_in == 0 && zs.avail_out > 0);
+                if (done) break;
+                if (zs.avail_out == 0)
+                {
+                    const std::size_t used = band.data.size();
+                    band.data.resize(used * 2);
+                    zs.next_out = band.data.data() + used;
+                    zs.avail_out = static_cast<uInt>(band.data.size() - used);
+                }
+            }
+        }
+        band.data.resize(band.data.size() - zs.avail_out);
+        band.adler = zs.adler;
+
+        // Later bands drop their own zlib header (2 bytes, 6 with FDICT)
+        if (b > 0)
+        {
+            const std::size_t header = (band.data.size() >= 2 && (band.data[1] & 0x20)) ? 6 : 2;
+            if (band.data.size() < header) return false;
+            band.data.erase(band.data.begin(), band.data.begin() + header);
+        }
+        return true;
+    };
+
+    ConvertStats::Timer idatTimer(ConvertStats::StageIdat);
+    uLong adler = 1;
+    std::size_t compressed = 0, chunkBytes = 0;
+    for (std::size_t first = 0; first < bandCount; first += windowSize)
+    {
+        const std::size_t n = (std::min)(windowSize, bandCount - first);
+        if (!ParallelFor(n, options.workers, [&](std::size_t i) { return deflateBand(first + i, window[i]); }))
+        {
+            DBG_MSG("SaveToPNG: banded deflate failed\n");
+            return 1;
+        }
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const std::size_t b = first + i;
+            Band &band = window[i];
+            if (b == 0)
+            {
+                adler = band.adler;
+            }
+            else
+            {
+                const int rowsInBand = (std::min)(bandRows, height - static_cast<int>(b) * bandRows);
+                adler = adler32_combine(adler, band.adler, static_cast<z_off_t>(rowsInBand * lineSize));
+            }
+
+            // Trailer of the last band becomes the Adler-32 of the whole stream
+            if (b + 1 == bandCount)
+            {
+                if (band.data.size() < 4) { DBG_MSG("SaveToPNG: banded deflate failed\n"); return 1; }
+                unsigned char *trailer = band.data.data() + band.data.size() - 4;
+                trailer[0] = static_cast<unsigned char>(adler >> 24);
+                trailer[1] = static_cast<unsigned char>(adler >> 16);
+                trailer[2] = static_cast<unsigned char>(adler >> 8);
+                trailer[3] = static_cast<unsigned char>(adler);
+            }
+
+            // --- IDAT chunks of at most IdatChunkSize, in band order ---
+            for (std::size_t at = 0; at < band.data.size(); at += PngIdatWriter<Stream>::IdatChunkSize)
+            {
+                const std::size_t len = (std::min)(band.data.size() - at, PngIdatWriter<Stream>::IdatChunkSize);
+                if (!write_PNG_Chunk(dst, "IDAT", band.data.data() + at, static_cast<unsigned int>(len))) { DBG_MSG("SaveToPNG: failed writing IDAT\n"); return 1; }
+                chunkBytes += len + 12;
+            }
+            compressed += band.data.size();
+        }
+    }
+    ConvertStats::instance().deflated(static_cast<std::uint64_t>(lineSize) * height, compressed);
+
+    if (!write_PNG_Chunk(dst, "IEND", nullptr, 0)) { DBG_MSG("SaveToPNG: failed writing IEND\n"); return 1; }
+    ConvertStats::instance().encoded(static_cast<std::uint64_t>(width) * height, head + chunkBytes + 12);
+
+    DBG_MSG("SaveToPNG: OK (%dx%d, %zu bands)\n", width, height, bandCount);
+    return 0;
+}
+
+// Whether a PNG of pixelCount pixels goes through SaveToPNGBands: only on
+// request (options.pngBands), since it needs the whole index plane
+static inline bool UsePngBands(const ConvertOptions &options, std::size_t pixelCount)
+{
+    return options.pngBands && options.workers != 1 && pixelCount >= ParallelMinPixels;
+}
+
+template <class Stream>
+static int SaveToPNGBands(Stream &dst,
+                          const unsigned char *pixels,
+                          int width, int height,
+                          const PaletteArtifacts &palette,
+                          const ConvertOptions &options)
+{
+    switch (options.pngMode)
+    {
+    case PNGMode::PNG_24: return SaveToPNGBandsAs<PNGMode::PNG_24>(dst, pixels, width, height, palette, options);
+    case PNGMode::PNG_32: return SaveToPNGBandsAs<PNGMode::PNG_32>(dst, pixels, width, height, palette, options);
+    default:              return SaveToPNGBandsAs<PNGMode::PNG_8>(dst, pixels, width, height, palette, options);
+    }
+}
+
+template <class Stream>
+static int SaveToPNG(Stream &dst,
+                     const unsigned char *pixels,
+                     int width, int height,
+                     const PaletteArtifacts &palette,
+                     const ConvertOptions &options)
+{
+    if (UsePngBands(options, static_cast<std::size_t>(width) * static_cast<std::size_t>(height)))
+        return SaveToPNGBands(dst, pixels, width, height, palette, options);
+    PixelPlaneRows rows = { pixels, static_cast<std::size_t>(width) };
+    return SaveToPNGRows(dst, rows, width, height, palette, options);
+}
+
+// ===================================================================
+// Expected output size for a conversion ID, used to pre-size buffers.
+// Exact for BMP, TGA and RAW8; for PNG a generous estimate (raw scanlines plus
+// chunk overhead), since the real size depends on how well it deflates.
+// ===================================================================
+static std::size_t EstimateOutputSize(const PidInfo &image, const char *cnv, const ConvertOptions &options)
+{
+    const std::size_t w = static_cast<std::size_t>(image.width);
+    const std::size_t h = static_cast<std::size_t>(image.height);
+    if (!cnv) return 0;
+    if (std::strcmp(cnv, "BMP") == 0) return 54 + ((w * 3 + 3) & ~static_cast<std::size_t>(3)) * h;
+    if (std::strcmp(cnv, "TGA8") == 0 || std::strcmp(cnv, "TGA") == 0) return TGAHeaderSize + w * h;
+    if (std::strcmp(cnv, "TGA8RLE") == 0) return TGAHeaderSize + (w + (w + 127) / 128) * h;
+    if (std::strcmp(cnv, "RAW8") == 0) return RawIndexHeadSize + w * h;
+    if (std::strcmp(cnv, "PNG") == 0)
+    {
+        const std::size_t bpp = (options.pngMode == PNGMode::PNG_8) ? 1 : (options.pngMode == PNGMode::PNG_24) ? 3 : 4;
+        return 8 + 25 + (768 + 12) + (256 + 12) + (w * bpp + 1) * h / 2 + 1024;
+    }
+    return 0;
+}
+
+// ===================================================================
+// Dispatch by DUCI conversion ID ("BMP", "TGA8"/"TGA", "TGA8RLE", "PNG", "RAW8")
+// - pixels is the width*height index plane (image.pixels or a plane from
+//   the scratch arena); image supplies size, palette and flags.
+// - options.transparency decides whether index 0 is written transparent.
+// - Returns 0 on success, 1 on write error or unsupported target.
+// ===================================================================
+template <class Stream>
+static int SaveToFormat(Stream &dst, const PidImage &image, const unsigned char *pixels, const char *cnv,
+                        const ConvertOptions &options)
+{
+    if (!cnv)
+    {
+        DBG_MSG("SaveToFormat: no target format\n");
+        return 1;
+    }
+    const std::shared_ptr<const PaletteArtifacts> palette =
+        PaletteCache::instance().intern(image.palette, ResolveTransparency(options, image.useTransparency));
+    if (std::strcmp(cnv, "BMP") == 0)
+    {
+        DBG_MSG("SaveToFormat: target BMP\n");
+        return SaveToBMP(dst, pixels, image.width, image.height, *palette);
+    }
+    if (std::strcmp(cnv, "TGA8") == 0 || std::strcmp(cnv, "TGA") == 0)
+    {
+        DBG_MSG("SaveToFormat: target TGA\n");
+        return SaveToTGA(dst, pixels, image.width, image.height, *palette);
+    }
+    if (std::strcmp(cnv, "TGA8RLE") == 0)
+    {
+        DBG_MSG("SaveToFormat: target TGA RLE\n");
+        return SaveToTGARLE(dst, pixels, image.width, image.height, *palette);
+    }
+    if (std::strcmp(cnv, "RAW8") == 0)
+    {
+        DBG_MSG("SaveToFormat: target RAW8\n");
+        return SaveToRAW8(dst, pixels, image.header, *palette);
+    }
+    if (std::strcmp(cnv, "PNG") == 0)
+    {
+        DBG_MSG("SaveToFormat: target PNG\n");
+        return SaveToPNG(dst, pixels, image.width, image.height, *palette, options);
+    }
+    DBG_MSG("SaveToFormat: unsupported target format: %s\n", cnv);
+    return 1;
+}
+
+template <class Stream>
+static int SaveToFormat(Stream &dst, const PidImage &image, const char *cnv, const ConvertOptions &options)
+{
+    return SaveToFormat(dst, image, image.pixels.data(), cnv, options);
+}
+
+// ===================================================================
+// Decode a complete in-memory .PID and write it as cnv
+// - PNG is pipelined: PidScanlineDecoder feeds the PNG filter/deflate
+//   stage one row at a time, so the W*H index plane is never allocated.
+//   Inverted images (rows stored bottom-up) go through PidInvertedRows,
+//   which keeps one band of stored rows. The stream is validated first,
+//   so a truncated file fails before anything is written, exactly like
+//   the full decode.
+// - Every other target is decompressed into an index plane from the
+//   scratch arena and goes through SaveToFormat.
+// - Images of ParallelMinPixels or more (unless options.workers is 1) are
+//   decoded in row bands on several threads. PNG keeps the pipelined path
+//   unless options.pngBands asks for the banded deflate (SaveToPNGBands),
+//   which needs the full plane.
+// - Returns 0 on success, 1 on decode/write error or unsupported target.
+// ===================================================================
+template <class Stream>
+static int ConvertPidData(Stream &dst, const unsigned char *data, std::size_t size, const char *cnv,
+                          const ConvertOptions &options)
+{
+    PidImage image;
+    if (!PidDecoder::parse_header(data, size, image) || !PidDecoder::load_palette(data, size, image))
+    {
+        DBG_MSG("ConvertPidData: invalid header or palette\n");
+        return 1;
+    }
+
+    ScratchArena::Scope scratch;
+    const std::size_t pixelCount = static_cast<std::size_t>(image.width) * static_cast<std::size_t>(image.height);
+    if (cnv && std::strcmp(cnv, "PNG") == 0 && !UsePngBands(options, pixelCount))
+    {
+        const std::shared_ptr<const PaletteArtifacts> palette =
+            PaletteCache::instance().intern(image.palette, ResolveTransparency(options, image.useTransparency));
+        if (image.invert)
+        {
+            PidInvertedRows rows(data, size, image);
+            if (!rows.valid())
+            {
+                DBG_MSG("ConvertPidData: pixel data is truncated\n");
+                return 1;
+            }
+            DBG_MSG("ConvertPidData: pipelined PNG, inverted (W=%d H=%d flags=0x%02X band=%d rows)\n",
+                    image.width, image.height, image.header.Flags, rows.band_rows());
+            return SaveToPNGRows(dst, rows, image.width, image.height, *palette, options);
+        }
+        PidScanlineDecoder rows(data, size, image);
+        if (!rows.validate())
+        {
+            DBG_MSG("ConvertPidData: pixel data is truncated\n");
+            return 1;
+        }
+        DBG_MSG("ConvertPidData: pipelined PNG (W=%d H=%d flags=0x%02X)\n", image.width, image.height, image.header.Flags);
+        return SaveToPNGRows(dst, rows, image.width, image.height, *palette, options);
+    }
+
+    unsigned char *pixels = scratch.arena().alloc_array<unsigned char>(pixelCount);
+    if (!PidDecoder::decompress_parallel(data, size, image, pixels, options.workers))
+    {
+        DBG_MSG("ConvertPidData: decode failed\n");
+        return 1;
+    }
+    DBG_MSG("ConvertPidData: decode OK (W=%d H=%d flags=0x%02X)\n", image.width, image.height, image.header.Flags);
+    return SaveToFormat(dst, image, pixels, cnv, options);
+}
+
+// ===================================================================
+// File extension for a conversion ID (".bmp", ".tga", ".png", ".raw")
+// - Returns nullptr for an unsupported ID.
+// ===================================================================
+static const char *FormatExtension(const char *cnv)
+{
+    if (!cnv) return nullptr;
+    if (std::strcmp(cnv, "BMP") == 0) return ".bmp";
+    if (std::strcmp(cnv, "TGA8") == 0 || std::strcmp(cnv, "TGA") == 0 || std::strcmp(cnv, "TGA8RLE") == 0) return ".tga";
+    if (std::strcmp(cnv, "PNG") == 0) return ".png";
+    if (std::strcmp(cnv, "RAW8") == 0) return ".raw";
+    return nullptr;
+}
+
+// ===================================================================
+// Split a conversion list ("BMP,PNG" or "BMP;TGA8;PNG") into IDs
+// - Empty items are dropped, a single ID yields a one-element list.
+// ===================================================================
+static std::vector<std::string> SplitFormatList(const std::string &list)
+{
+    std::vector<std::string> formats;
+    std::size_t start = 0;
+    while (start <= list.size())
+    {
+        std::size_t end = list.find_first_of(",; ", start);
+        if (end == std::string::npos) end = list.size();
+        if (end > start) formats.push_back(list.substr(start, end - start));
+        start = end + 1;
+    }
+    return formats;
+}
+
+// ===================================================================
+// Output suffix for formats[index] in a multi-format export
+// - The plain extension, unless an earlier target already uses it
+//   (TGA8 + TGA8RLE), in which case the ID is prepended: ".tga8rle.tga".
+// ===================================================================
+static std::string ExportSuffix(const std::vector<std::string> &formats, std::size_t index)
+{
+    const char *ext = FormatExtension(formats[index].c_str());
+    if (!ext) return std::string();
+    for (std::size_t i = 0; i < index; ++i)
+    {
+        const char *other = FormatExtension(formats[i].c_str());
+        if (other && std::strcmp(other, ext) == 0)
+        {
+            std::string suffix = ".";
+            for (char c : formats[index]) suffix += static_cast<char>((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c);
+            return suffix + ext;
+        }
+    }
+    return ext;
+}
+
+// ===================================================================
+// One destination of a multi-format export
+// ===================================================================
+template <class Stream>
+struct ExportTarget
+{
+    const char *cnv = nullptr;  // DUCI conversion ID
+    Stream *output = nullptr;   // destination, one stream per target
+    int result = 1;             // 0 on success, set by SaveToFormats
+};
+
+// ===================================================================
+// Encode one decoded image into several formats
+// - The index plane and palette are shared read-only by all encoders.
+// - With concurrent set (and more than one core), every target after the
+//   first gets its own thread while the first runs on the caller's
+//   thread; if a thread cannot be started that target runs inline.
+// - Returns 0 if every target succeeded, 1 otherwise (see result).
+// ===================================================================
+template <class Stream>
+static int SaveToFormats(const PidImage &image, ExportTarget<Stream> *targets, std::size_t count,
+                         const ConvertOptions &options, bool concurrent)
+{
+    auto encode = [&image, &options](ExportTarget<Stream> &target) {
+        try
+        {
+            target.result = target.output ? SaveToFormat(*target.output, image, target.cnv, options) : 1;
+        }
+        catch (...)
+        {
+            DBG_MSG("SaveToFormats: exception in %s encoder\n", target.cnv ? target.cnv : "?");
+            target.result = 1;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    if (concurrent && count > 1 && std::thread::hardware_concurrency() > 1)
+    {
+        workers.reserve(count - 1);
+        for (std::size_t i = 1; i < count; ++i)
+        {
+            try
+            {
+                workers.emplace_back(encode, std::ref(targets[i]));
+            }
+            catch (...)
+            {
+                DBG_MSG("SaveToFormats: cannot start thread, encoding %s inline\n", targets[i].cnv ? targets[i].cnv : "?");
+                encode(targets[i]);
+            }
+        }
+        encode(targets[0]);
+        for (auto &worker : workers) worker.join();
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; ++i) encode(targets[i]);
+    }
+
+    int failed = 0;
+    for (std::size_t i = 0; i < count; ++i) failed |= targets[i].result;
+    return failed ? 1 : 0;
+}
+
+// ===================================================================
+// Decode a complete in-memory .PID once and write it to every target
+// - Always does a full decode (the plane is shared, so the pipelined
+//   PNG path of ConvertPidData does not apply), banded for large images.
+// - Returns 0 if every target succeeded, 1 on decode error or if any
+//   target failed.
+// ===================================================================
+template <class Stream>
+static int ExportPidData(const unsigned char *data, std::size_t size,
+                         ExportTarget<Stream> *targets, std::size_t count,
+                         const ConvertOptions &options, bool concurrent)
+{
+    PidImage image;
+    if (!PidDecoder::decode(data, size, image, options.workers))
+    {
+        DBG_MSG("ExportPidData: decode failed\n");
+        for (std::size_t i = 0; i < count; ++i) targets[i].result = 1;
+        return 1;
+    }
+    DBG_MSG("ExportPidData: decode OK (W=%d H=%d flags=0x%02X), %zu target(s)\n",
+            image.width, image.height, image.header.Flags, count);
+    return SaveToFormats(image, targets, count, options, concurrent);
+}
+
+#endif // PID_ENCODERS_H
@@ -0,0 +1,504 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_import.cpp
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      BMP / TGA / PNG / RAW8 readers for re-packing art into .PID
+ *
+ *  DETAILS:
+ *      Implementation of ImportImage (one reader per format, all working
+ *      on an in-memory span; PNG data is inflated with zlib's uncompress
+ *      and unfiltered row by row) and BuildPidImage (transparency
+ *      decision, palette choice, PidEncoder::quantize / map_colors).
+ * ============================================================================
+ */
+
+#ifdef _DEBUG
+#include <windows.h> // OutputDebugStringA for DBG_MSG
+#endif
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <zlib.h>
+#include "pid_import.h"
+
+
+namespace
+{
+    const std::uint64_t MaxPixels = 1ULL << 30;     // same limit as PidDecoder::parse_header
+
+    inline std::uint32_t LE16(const unsigned char *p) { return p[0] | (p[1] << 8); }
+    inline std::uint32_t LE32(const unsigned char *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<std::uint32_t>(p[3]) << 24); }
+    inline std::uint32_t BE32(const unsigned char *p) { return (static_cast<std::uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+
+    bool SizeOk(std::int64_t width, std::int64_t height)
+    {
+        return width > 0 && height > 0 && static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height) <= MaxPixels;
+    }
+
+    void Allocate(ImportedImage &image, int width, int height, bool indexed)
+    {
+        image.width = width;
+        image.height = height;
+        image.indexed = indexed;
+        for (int i = 0; i < 256; ++i) image.palette[i] = Color{ 0, 0, 0, 255 };
+        const std::size_t count = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+        if (indexed) image.indices.assign(count, 0);
+        else         image.pixels.assign(count, Color{ 0, 0, 0, 255 });
+    }
+
+    // ===================================================================
+    // BMP (BI_RGB 8/24/32bpp, BI_BITFIELDS 32bpp as BGRA)
+    // ===================================================================
+    bool ReadBMP(const unsigned char *data, std::size_t size, ImportedImage &image)
+    {
+        if (size < 54) return false;
+        const std::uint32_t offBits = LE32(data + 10);
+        const std::uint32_t infoSize = LE32(data + 14);
+        if (infoSize < 40 || infoSize > size - 14) return false;
+        const std::int64_t width = static_cast<std::int32_t>(LE32(data + 18));
+        std::int64_t height = static_cast<std::int32_t>(LE32(data + 22));
+        const std::uint32_t bpp = LE16(data + 28);
+        const std::uint32_t compression = LE32(data + 30);
+        const std::uint32_t used = LE32(data + 46);
+
+        const bool topDown = height < 0;
+        if (topDown) height = -height;
+        if (!SizeOk(width, height)) return false;
+        if (bpp != 8 && bpp != 24 && bpp != 32) { DBG_MSG("ImportImage: BMP %u bpp not supported\n", bpp); return false; }
+        if (!(compression == 0 || (compression == 3 && bpp == 32))) { DBG_MSG("ImportImage: compressed BMP not supported\n"); return false; }
+
+        const std::uint64_t stride = ((static_cast<std::uint64_t>(width) * bpp + 31) / 32) * 4;
+        if (offBits > size || stride * static_cast<std::uint64_t>(height) > size - offBits) return false;
+
+        const int w = static_cast<int>(width), h = static_cast<int>(height);
+        Allocate(image, w, h, bpp == 8);
+        if (bpp == 8)
+        {
+            const std::uint32_t entries = used ? used : 256;
+            const std::size_t table = 14 + infoSize + (compression == 3 ? 12 : 0);
+            if (entries > 256 || table + 4 * entries > size) return false;
+            for (std::uint32_t i = 0; i < entries; ++i)
+            {
+                const unsigned char *q = data + table + 4 * i;
+                image.palette[i] = Color{ q[2], q[1], q[0], 255 };
+            }
+        }
+
+        bool anyAlpha = false;
+        for (int y = 0; y < h; ++y)
+        {
+            const unsigned char *row = data + offBits + stride * static_cast<std::uint64_t>(topDown ? y : h - 1 - y);
+            const std::size_t line = static_cast<std::size_t>(y) * w;
+            for (int x = 0; x < w; ++x)
+            {
+                if (bpp == 8) { image.indices[line + x] = row[x]; continue; }
+                const unsigned char *q = row + x * (bpp / 8);
+                Color &c = image.pixels[line + x];
+                c = Color{ q[2], q[1], q[0], bpp == 32 ? q[3] : static_cast<unsigned char>(255) };
+                anyAlpha |= (bpp == 32 && q[3] != 0);
+            }
+        }
+        // Most 32bpp BMPs leave the fourth byte at 0: that means opaque
+        if (bpp == 32 && !anyAlpha)
+            for (Color &c : image.pixels) c.a = 255;
+        return true;
+    }
+
+    // ===================================================================
+    // TGA (types 1/2/3, RLE 9/10/11)
+    // ===================================================================
+    bool ReadTGA(const unsigned char *data, std::size_t size, ImportedImage &image)
+    {
+        if (size < 18) return false;
+        const unsigned idLength = data[0], cmapType = data[1], type = data[2];
+        const std::uint32_t cmapFirst = LE16(data + 3), cmapLength = LE16(data + 5), cmapDepth = data[7];
+        const int width = static_cast<int>(LE16(data + 12)), height = static_cast<int>(LE16(data + 14));
+        const unsigned depth = data[16], descriptor = data[17];
+
+        const unsigned base = type & ~8u;
+        const bool rle = (type & 8u) != 0;
+        if (cmapType > 1 || (base != 1 && base != 2 && base != 3) || !SizeOk(width, height)) return false;
+        if (base == 1 && (cmapType != 1 || depth != 8)) return false;
+        if (base == 2 && depth != 24 && depth != 32) { DBG_MSG("ImportImage: TGA %u bpp not supported\n", depth); return false; }
+        if (base == 3 && depth != 8) return false;
+        if (cmapType == 1 && cmapDepth != 24 && cmapDepth != 32) { DBG_MSG("ImportImage: TGA colormap depth %u not supported\n", cmapDepth); return false; }
+
+        std::size_t pos = 18 + idLength;
+        Allocate(image, width, height, base == 1);
+        if (cmapType == 1)
+        {
+            const std::size_t entryBytes = cmapDepth / 8;
+            if (pos + entryBytes * cmapLength > size) return false;
+            if (base == 1 && cmapFirst + cmapLength > 256) return false;
+            if (base == 1)
+            {
+                for (std::uint32_t i = 0; i < cmapLength; ++i)
+                {
+                    const unsigned char *q = data + pos + entryBytes * i;
+                    image.palette[cmapFirst + i] = Color{ q[2], q[1], q[0], entryBytes == 4 ? q[3] : static_cast<unsigned char>(255) };
+                }
+            }
+            pos += entryBytes * cmapLength;
+        }
+
+        // Pixel data in stored order (RLE packets may cross rows)
+        const std::size_t bytes = depth / 8;
+        const std::size_t count = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+        std::vector<unsigned char> stored;
+        const unsigned char *src = data + pos;
+        if (!rle)
+        {
+            if (pos > size || count * bytes > size - pos) return false;
+        }
+        else
+        {
+            stored.resize(count * bytes);
+            std::size_t produced = 0;
+            while (produced < count)
+            {
+                if (pos >= size) return false;
+                const unsigned header = data[pos++];
+                const std::size_t n = (std::min)(static_cast<std::size_t>((header & 0x7F) + 1), count - produced);
+                if (header & 0x80)
+                {
+                    if (bytes > size - pos) return false;
+                    for (std::size_t k = 0; k < n; ++k) std::memcpy(&stored[(produced + k) * bytes], data + pos, bytes);
+                    pos += bytes;
+                }
+                else
+                {
+                    if (n * bytes > size - pos) return false;
+                    std::memcpy(&stored[produced * bytes], data + pos, n * bytes);
+                    pos += n * bytes;
+                }
+                produced += n;
+            }
+            src = stored.data();
+        }
+
+        const bool topOrigin = (descriptor & 0x20) != 0;
+        const bool rightOrigin = (descriptor & 0x10) != 0;
+        const bool useAlpha = depth == 32 && (descriptor & 0x0F) != 0;
+        for (int r = 0; r < height; ++r)
+        {
+            const int y = topOrigin ? r : height - 1 - r;
+            for (int c = 0; c < width; ++c)
+            {
+                const int x = rightOrigin ? width - 1 - c : c;
+                const unsigned char *q = src + (static_cast<std::size_t>(r) * width + c) * bytes;
+                const std::size_t at = static_cast<std::size_t>(y) * width + x;
+                if (base == 1)      image.indices[at] = q[0];
+                else if (base == 3) image.pixels[at] = Color{ q[0], q[0], q[0], 255 };
+                else                image.pixels[at] = Color{ q[2], q[1], q[0], useAlpha ? q[3] : static_cast<unsigned char>(255) };
+            }
+        }
+        return true;
+    }
+
+    // ===================================================================
+    // PNG (non-interlaced; indexed and gray 1/2/4/8-bit, GA/RGB/RGBA 8-bit)
+    // ===================================================================
+    unsigned char Paeth(int a, int b, int c)
+    {
+        const int p = a + b - c;
+        const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        return static_cast<unsigned char>((pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c);
+    }
+
+    bool ReadPNG(const unsigned char *data, std::size_t size, ImportedImage &image)
+    {
+        std::uint32_t width = 0, height = 0;
+        unsigned depth = 0, colorType = 0, interlace = 0;
+        bool haveHeader = false;
+        unsigned char trns[256];
+        std::size_t trnsLength = 0;
+        Color palette[256];
+        for (int i = 0; i < 256; ++i) palette[i] = Color{ 0, 0, 0, 255 };
+        std::vector<unsigned char> compressed;
+
+        std::size_t pos = 8;
+        while (pos + 12 <= size)
+        {
+            const std::uint32_t length = BE32(data + pos);
+            if (length > size - pos - 12) return false;
+            const unsigned char *type = data + pos + 4;
+            const unsigned char *body = data + pos + 8;
+            if (std::memcmp(type, "IHDR", 4) == 0 && length >= 13)
+            {
+                width = BE32(body);
+                height = BE32(body + 4);
+                depth = body[8];
+                colorType = body[9];
+                interlace = body[12];
+                if (body[10] != 0 || body[11] != 0) return false;
+                haveHeader = true;
+            }
+            else if (std::memcmp(type, "PLTE", 4) == 0)
+            {
+                const std::size_t entries = (std::min)(static_cast<std::size_t>(length / 3), static_cast<std::size_t>(256));
+                for (std::size_t i = 0; i < entries; ++i) palette[i] = Color{ body[3 * i], body[3 * i + 1], body[3 * i + 2], 255 };
+            }
+            else if (std::memcmp(type, "tRNS", 4) == 0)
+            {
+                trnsLength = (std::min)(static_cast<std::size_t>(length), sizeof(trns));
+                std::memcpy(trns, body, trnsLength);
+            }
+            else if (std::memcmp(type, "IDAT", 4) == 0)
+            {
+                compressed.insert(compressed.end(), body, body + length);
+            }
+            else if (std::memcmp(type, "IEND", 4) == 0)
+            {
+                break;
+            }
+            pos += 12 + length;
+        }
+
+        if (!haveHeader || static_cast<std::int32_t>(width) <= 0 || static_cast<std::int32_t>(height) <= 0 ||
+            !SizeOk(width, height)) return false;
+        if (interlace != 0) { DBG_MSG("ImportImage: interlaced PNG not supported\n"); return false; }
+        unsigned channels = 0;
+        switch (colorType)
+        {
+        case 0: channels = 1; break;
+        case 2: channels = 3; break;
+        case 3: channels = 1; break;
+        case 4: channels = 2; break;
+        case 6: channels = 4; break;
+        default: return false;
+        }
+        const bool lowDepthOk = (colorType == 0 || colorType == 3) && (depth == 1 || depth == 2 || depth == 4);
+        if (depth != 8 && !lowDepthOk) { DBG_MSG("ImportImage: PNG bit depth %u not supported\n", depth); return false; }
+
+        const unsigned bitsPerPixel = channels * depth;
+        const std::uint64_t rowBytes = (static_cast<std::uint64_t>(width) * bitsPerPixel + 7) / 8;
+        const std::uint64_t rawSize = (rowBytes + 1) * height;
+        if (rawSize > 0xFFFFFFFFu || compressed.empty()) return false;
+        std::vector<unsigned char> raw(static_cast<std::size_t>(rawSize));
+        uLongf rawLength = static_cast<uLongf>(rawSize);
+        if (uncompress(raw.data(), &rawLength, compressed.data(), static_cast<uLong>(compressed.size())) != Z_OK ||
+            rawLength != rawSize)
+        {
+            DBG_MSG("ImportImage: PNG image data is corrupt\n");
+            return false;
+        }
+
+        // Undo the row filters in place
+        const std::size_t stride = static_cast<std::size_t>(rowBytes);
+        const std::size_t left = (std::max)(bitsPerPixel / 8, 1u);
+        for (std::uint32_t y = 0; y < height; ++y)
+        {
+            unsigned char *row = raw.data() + y * (stride + 1);
+            const unsigned char filter = row[0];
+            unsigned char *cur = row + 1;
+            const unsigned char *prev = y ? raw.data() + (y - 1) * (stride + 1) + 1 : nullptr;
+            for (std::size_t i = 0; i < stride; ++i)
+            {
+                const int a = i >= left ? cur[i - left] : 0;
+                const int b = prev ? prev[i] : 0;
+                const int c = (prev && i >= left) ? prev[i - left] : 0;
+                switch (filter)
+                {
+                case 0: break;
+                case 1: cur[i] = static_cast<unsigned char>(cur[i] + a); break;
+                case 2: cur[i] = static_cast<unsigned char>(cur[i] + b); break;
+                case 3: cur[i] = static_cast<unsigned char>(cur[i] + ((a + b) >> 1)); break;
+                case 4: cur[i] = static_cast<unsigned char>(cur[i] + Paeth(a, b, c)); break;
+                default: return false;
+                }
+            }
+        }
+
+        const int w = static_cast<int>(width), h = static_cast<int>(height);
+        Allocate(image, w, h, colorType == 3);
+        if (colorType == 3)
+        {
+            std::memcpy(image.palette, palette, sizeof(palette));
+            for (std::size_t i = 0; i < trnsLength; ++i) image.palette[i].a = trns[i];
+        }
+        const unsigned maxSample = (1u << depth) - 1;
+        for (int y = 0; y < h; ++y)
+        {
+            const unsigned char *row = raw.data() + static_cast<std::size_t>(y) * (stride + 1) + 1;
+            const std::size_t line = static_cast<std::size_t>(y) * w;
+            for (int x = 0; x < w; ++x)
+            {
+                if (depth < 8)
+                {
+                    const std::size_t bit = static_cast<std::size_t>(x) * depth;
+                    const unsigned sample = (row[bit / 8] >> (8 - depth - bit % 8)) & maxSample;
+                    if (colorType == 3) { image.indices[line + x] = static_cast<unsigned char>(sample); continue; }
+                    const unsigned char g = static_cast<unsigned char>(sample * 255 / maxSample);
+                    const bool keyed = trnsLength >= 2 && static_cast<unsigned>((trns[0] << 8) | trns[1]) == sample;
+                    image.pixels[line + x] = Color{ g, g, g, static_cast<unsigned char>(keyed ? 0 : 255) };
+                    continue;
+                }
+                const unsigned char *q = row + static_cast<std::size_t>(x) * channels;
+                if (colorType == 3) { image.indices[line + x] = q[0]; continue; }
+                Color &c = image.pixels[line + x];
+                switch (colorType)
+                {
+                case 0: c = Color{ q[0], q[0], q[0], static_cast<unsigned char>(trnsLength >= 2 && ((trns[0] << 8) | trns[1]) == q[0] ? 0 : 255) }; break;
+                case 4: c = Color{ q[0], q[0], q[0], q[1] }; break;
+                case 6: c = Color{ q[0], q[1], q[2], q[3] }; break;
+                default:
+                {
+                    const bool keyed = trnsLength >= 6 && ((trns[0] << 8) | trns[1]) == q[0] &&
+                        ((trns[2] << 8) | trns[3]) == q[1] && ((trns[4] << 8) | trns[5]) == q[2];
+                    c = Color{ q[0], q[1], q[2], static_cast<unsigned char>(keyed ? 0 : 255) };
+                    break;
+                }
+                }
+            }
+        }
+        return true;
+    }
+
+    // ===================================================================
+    // RAW8 + PAL (see RawIndexHeader)
+    // ===================================================================
+    bool ReadRAW8(const unsigned char *data, std::size_t size, ImportedImage &image)
+    {
+        if (size < sizeof(RawIndexHeader)) return false;
+        RawIndexHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.Version != 1 || header.HeaderSize < sizeof(RawIndexHeader) || !SizeOk(header.Width, header.Height))
+            return false;
+        const std::uint64_t count = static_cast<std::uint64_t>(header.Width) * static_cast<std::uint64_t>(header.Height);
+        if (static_cast<std::uint64_t>(header.HeaderSize) + 1024 > size || header.PixelOffset > size ||
+            count > size - header.PixelOffset) return false;
+
+        Allocate(image, header.Width, header.Height, true);
+        std::memcpy(image.palette, data + header.HeaderSize, sizeof(image.palette));
+        std::memcpy(image.indices.data(), data + header.PixelOffset, static_cast<std::size_t>(count));
+        image.hasPidHeader = true;
+        image.pidFlags = header.Flags;
+        std::memcpy(image.U, header.U, sizeof(image.U));
+        return true;
+    }
+}
+
+bool ImportImage(const unsigned char *data, std::size_t size, ImportedImage &image)
+{
+    image = ImportedImage();
+    if (!data || size < 4) return false;
+    static const unsigned char pngSignature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+    if (size >= 8 && std::memcmp(data, pngSignature, 8) == 0) return ReadPNG(data, size, image);
+    if (std::memcmp(data, "RAW8", 4) == 0) return ReadRAW8(data, size, image);
+    if (data[0] == 'B' && data[1] == 'M') return ReadBMP(data, size, image);
+    return ReadTGA(data, size, image);
+}
+
+// ===================================================================
+// ImportedImage -> PidImage
+// ===================================================================
+bool BuildPidImage(const ImportedImage &source, const PidImportOptions &options, PidImage &pid)
+{
+    if (source.width <= 0 || source.height <= 0) return false;
+    if (options.choice == PidPaletteChoice::Fixed && !options.palette) return false;
+    const std::size_t count = static_cast<std::size_t>(source.width) * static_cast<std::size_t>(source.height);
+
+    // --- Transparency: from the source alpha unless forced ---
+    bool transparent = options.transparency == TransparencyPolicy::Always;
+    if (options.transparency == TransparencyPolicy::FromFlags)
+    {
+        if (source.hasPidHeader)
+        {
+            transparent = (source.pidFlags & PID_FLAG_TRANSPARENT) != 0;
+        }
+        else if (source.indexed)
+        {
+            bool used[256] = {};
+            for (std::size_t i = 0; i < count; ++i) used[source.indices[i]] = true;
+            for (int i = 0; i < 256 && !transparent; ++i) transparent = used[i] && source.palette[i].a < 128;
+        }
+        else
+        {
+            for (std::size_t i = 0; i < count && !transparent; ++i) transparent = source.pixels[i].a < 128;
+        }
+    }
+
+    // --- Header fields ---
+    std::memset(&pid.header, 0, sizeof(pid.header));
+    pid.header.ID = 10;
+    pid.header.Width = source.width;
+    pid.header.Height = source.height;
+    pid.width = source.width;
+    pid.height = source.height;
+    pid.useTransparency = transparent;
+    pid.mirror = source.hasPidHeader && (source.pidFlags & PID_FLAG_MIRROR) != 0;
+    pid.invert = source.hasPidHeader && (source.pidFlags & PID_FLAG_INVERT) != 0;
+    pid.rleCompression = source.hasPidHeader ? (source.pidFlags & PID_FLAG_RLE) != 0 : options.rle;
+    if (source.hasPidHeader)
+    {
+        pid.header.Flags = source.pidFlags & PID_FLAG_MASK;
+        std::memcpy(pid.header.U, source.U, sizeof(pid.header.U));
+    }
+
+    // --- Palette and indices ---
+    pid.pixels.resize(count);
+    if (options.choice == PidPaletteChoice::Auto && source.indexed)
+    {
+        std::memcpy(pid.palette, source.palette, sizeof(pid.palette));
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const unsigned char index = source.indices[i];
+            pid.pixels[i] = (transparent && source.palette[index].a < 128) ? 0 : index;
+        }
+    }
+    else
+    {
+        std::vector<Color> expanded;
+        const Color *colors = source.pixels.data();
+        if (source.indexed)
+        {
+            expanded.resize(count);
+            for (std::size_t i = 0; i < count; ++i) expanded[i] = source.palette[source.indices[i]];
+            colors = expanded.data();
+        }
+        if (options.choice == PidPaletteChoice::Auto)
+            PidEncoder::quantize(colors, count, transparent, pid.palette);
+        else
+            std::memcpy(pid.palette, options.choice == PidPaletteChoice::Default ? defaultPalette : options.palette, sizeof(pid.palette));
+        PidEncoder::map_colors(colors, count, pid.palette, transparent, pid.pixels.data());
+    }
+
+    // Alpha as PidDecoder::load_palette reports it; embedded unless it is
+    // the default table and the source did not carry flag 0x80
+    bool isDefault = true;
+    for (int i = 0; i < 256; ++i)
+    {
+        pid.palette[i].a = 255;
+        isDefault = isDefault && pid.palette[i].r == defaultPalette[i].r && pid.palette[i].g == defaultPalette[i].g &&
+            pid.palette[i].b == defaultPalette[i].b;
+    }
+    if (transparent) pid.palette[0].a = 0;
+    pid.hasPalette = !isDefault || (source.hasPidHeader && (source.pidFlags & PID_FLAG_PALETTE) != 0);
+    pid.header.Flags = PidEncoder::header_flags(pid);
+    return true;
+}
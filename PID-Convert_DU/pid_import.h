@@ -0,0 +1,115 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_import.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      BMP / TGA / PNG / RAW8 readers for re-packing art into .PID
+ *
+ *  DETAILS:
+ *      ImportImage reads an image held in memory into ImportedImage:
+ *      an index plane plus palette for 8bpp sources (BMP 8bpp, TGA
+ *      colormapped, PNG indexed, RAW8), RGBA pixels otherwise. Covers
+ *      what the exporters of this project write and the usual output of
+ *      image editors: uncompressed BMP (8/24/32bpp, either row order),
+ *      TGA types 1/2/3 and their RLE forms 9/10/11 (8bpp indices with a
+ *      24/32-bit colormap, 8bpp gray, 24/32bpp color, any origin),
+ *      non-interlaced PNG (indexed 1/2/4/8-bit, gray 8-bit, gray+alpha,
+ *      RGB and RGBA 8-bit, tRNS honored). BuildPidImage then turns an
+ *      ImportedImage into a PidImage ready for PidEncoder::encode.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef PID_IMPORT_H
+#define PID_IMPORT_H
+
+#include <cstddef>
+#include <vector>
+#include "pid_convert.h"
+#include "pid_decoder.h"
+#include "pid_encoder.h"
+
+
+// =======================
+// Decoded source image
+// =======================
+struct ImportedImage
+{
+    int width = 0;
+    int height = 0;
+
+    bool indexed = false;               // indices + palette hold the image
+    Color palette[256];                 // source palette (alpha from tRNS / colormap)
+    std::vector<unsigned char> indices; // width*height, top-down
+    std::vector<Color> pixels;          // width*height RGBA, top-down (true-color sources)
+
+    bool hasPidHeader = false;          // RAW8: the .PID flags (0x80 included) and U[0..3] are known
+    int pidFlags = 0;
+    int U[4] = { 0, 0, 0, 0 };
+};
+
+// ------------------------------------------------------------------
+// ImportImage()
+// ------------------------------------------------------------------
+// Detects the format by signature (BMP "BM", PNG, RAW8), anything else
+// is tried as TGA.
+// - Returns: false if the format is not recognized, not supported or
+//   the data is truncated.
+bool ImportImage(const unsigned char *data, std::size_t size, ImportedImage &image);
+
+
+// =======================
+// Source image -> PidImage
+// =======================
+enum class PidPaletteChoice : unsigned char
+{
+    Auto,       // indexed source: its own palette and indices; true-color: exact or median cut
+    Default,    // defaultPalette (not embedded in the .PID)
+    Fixed       // PidImportOptions::palette (embedded unless it is defaultPalette)
+};
+
+struct PidImportOptions
+{
+    PidPaletteChoice choice = PidPaletteChoice::Auto;
+    const Color *palette = nullptr;                     // 256 entries for Fixed
+    TransparencyPolicy transparency = TransparencyPolicy::FromFlags;   // FromFlags: from the source alpha
+    bool rle = true;                                    // RLE, otherwise raw/repeat coding (RAW8 keeps its own)
+};
+
+// ------------------------------------------------------------------
+// BuildPidImage()
+// ------------------------------------------------------------------
+// Fills pid (size, flags, U, palette, index plane) from source. Pixels
+// are mapped to the chosen palette; with transparency on, pixels with
+// alpha < 128 become index 0 and flag 0x01 is set. A RAW8 source keeps
+// its mirror / invert / RLE / palette flags and all four U values, so a
+// RAW8 export packs back into a .PID with the original header (a palette
+// equal to the default table stays embedded if the original had 0x80).
+// pid.header.Flags is set to what PidEncoder::encode will write.
+// - Returns: false if the source is empty or Fixed has no palette.
+bool BuildPidImage(const ImportedImage &source, const PidImportOptions &options, PidImage &pid);
+
+#endif // PID_IMPORT_H
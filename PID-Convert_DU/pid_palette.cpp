@@ -0,0 +1,170 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_palette.cpp
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Interned palettes with precomputed encoder artifacts
+ *
+ *  DETAILS:
+ *      Implementation of PaletteArtifacts::build and PaletteCache (FNV-1a
+ *      hash buckets under a mutex, full memcmp before a hit).
+ * ============================================================================
+ */
+
+#include <cstring>
+#include "pid_palette.h"
+#include "pid_simd.h"
+
+
+// ===================================================================
+// Artifacts
+// ===================================================================
+static unsigned char *PutBE32(unsigned char *p, std::uint32_t v)
+{
+    p[0] = static_cast<unsigned char>(v >> 24);
+    p[1] = static_cast<unsigned char>(v >> 16);
+    p[2] = static_cast<unsigned char>(v >> 8);
+    p[3] = static_cast<unsigned char>(v);
+    return p + 4;
+}
+
+// Complete chunk in out: length, type, data (already at out + 8), CRC over type + data
+static void FinishPngChunk(unsigned char *out, const char *type, std::uint32_t length)
+{
+    PutBE32(out, length);
+    std::memcpy(out + 4, type, 4);
+    PutBE32(out + 8 + length, crc32_png(out + 4, 4 + length));
+}
+
+void PaletteArtifacts::build(const Color *source, bool useTransparency)
+{
+    std::memcpy(palette, source, sizeof(palette));
+    transparent = useTransparency;
+
+    for (int i = 0; i < 256; ++i)
+    {
+        const Color &c = palette[i];
+        const bool black = useTransparency && i == 0; // transparent -> black for BMP/TGA
+        const unsigned char r = black ? 0 : c.r, g = black ? 0 : c.g, b = black ? 0 : c.b;
+
+        bgr[i] = PackColorBytes(b, g, r, 0);
+        rgba[i] = PackColorBytes(c.r, c.g, c.b, (useTransparency && i == 0) ? 0 : 255);
+        tgaColormap[i * 3 + 0] = b;
+        tgaColormap[i * 3 + 1] = g;
+        tgaColormap[i * 3 + 2] = r;
+
+        plteChunk[8 + i * 3 + 0] = c.r;
+        plteChunk[8 + i * 3 + 1] = c.g;
+        plteChunk[8 + i * 3 + 2] = c.b;
+        trnsChunk[8 + i] = (i == 0) ? 0 : 255;
+    }
+    FinishPngChunk(plteChunk, "PLTE", 768);
+    FinishPngChunk(trnsChunk, "tRNS", 256);
+}
+
+// ===================================================================
+// Intern table
+// ===================================================================
+std::uint64_t PaletteCache::hash(const Color *palette, bool useTransparency)
+{
+    // FNV-1a over the 1 KiB table plus the transparency bit
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(palette);
+    std::uint64_t h = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < 256 * sizeof(Color); ++i)
+    {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    h ^= useTransparency ? 1u : 0u;
+    h *= 1099511628211ULL;
+    return h;
+}
+
+std::shared_ptr<const PaletteArtifacts> PaletteCache::intern(const Color *palette, bool useTransparency)
+{
+    const std::uint64_t h = hash(palette, useTransparency);
+    {
+        std::lock_guard<std::mutex> guard(fLock);
+        auto it = fTable.find(h);
+        if (it != fTable.end())
+        {
+            for (const auto &entry : it->second)
+            {
+                if (entry->transparent == useTransparency && std::memcmp(entry->palette, palette, sizeof(entry->palette)) == 0)
+                {
+                    ++fHits;
+                    return entry;
+                }
+            }
+        }
+    }
+
+    // Build outside the lock; a concurrent duplicate is harmless
+    std::shared_ptr<PaletteArtifacts> built = std::make_shared<PaletteArtifacts>();
+    built->build(palette, useTransparency);
+
+    std::lock_guard<std::mutex> guard(fLock);
+    ++fMisses;
+    if (fCount >= MaxEntries)
+    {
+        fTable.clear();
+        fCount = 0;
+    }
+    fTable[h].push_back(built);
+    ++fCount;
+    return built;
+}
+
+std::size_t PaletteCache::size() const
+{
+    std::lock_guard<std::mutex> guard(fLock);
+    return fCount;
+}
+
+std::uint64_t PaletteCache::hits() const
+{
+    std::lock_guard<std::mutex> guard(fLock);
+    return fHits;
+}
+
+std::uint64_t PaletteCache::misses() const
+{
+    std::lock_guard<std::mutex> guard(fLock);
+    return fMisses;
+}
+
+void PaletteCache::clear()
+{
+    std::lock_guard<std::mutex> guard(fLock);
+    fTable.clear();
+    fCount = 0;
+}
+
+PaletteCache &PaletteCache::instance()
+{
+    static PaletteCache cache;
+    return cache;
+}
@@ -0,0 +1,111 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_palette.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Interned palettes with precomputed encoder artifacts
+ *
+ *  DETAILS:
+ *      Most .PID files use defaultPalette and many of the rest embed the
+ *      same 768-byte table, so everything the encoders derive from a
+ *      palette (BGR / RGBA expansion tables, the TGA colormap with index 0
+ *      blacked out, complete PNG PLTE and tRNS chunks with their CRCs) is
+ *      built once per distinct palette + transparency and shared.
+ *      PaletteCache interns them by hash (full compare on collision),
+ *      hands out shared_ptr<const PaletteArtifacts> and is thread-safe.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef PID_PALETTE_H
+#define PID_PALETTE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "pid_convert.h"
+
+
+// =======================
+// Per-palette artifacts
+// =======================
+struct PaletteArtifacts
+{
+    Color palette[256];                 // resolved palette as decoded
+    bool transparent = false;           // index 0 written transparent
+
+    std::uint32_t bgr[256];             // B,G,R,0 per index, index 0 black if transparent (BMP)
+    std::uint32_t rgba[256];            // R,G,B,A per index, alpha 0 at index 0 if transparent (PNG 24/32)
+    unsigned char tgaColormap[768];     // B,G,R per index, index 0 black if transparent (TGA)
+    unsigned char plteChunk[12 + 768];  // complete PNG PLTE chunk (length, type, data, CRC)
+    unsigned char trnsChunk[12 + 256];  // complete PNG tRNS chunk (only written if transparent)
+
+    // ------------------------------------------------------------------
+    // build()
+    // ------------------------------------------------------------------
+    // Fills every artifact from palette and the transparency decision.
+    void build(const Color *source, bool useTransparency);
+};
+
+
+// =======================
+// Intern table
+// =======================
+class PaletteCache
+{
+public:
+    static const std::size_t MaxEntries = 256;
+
+    // ------------------------------------------------------------------
+    // intern()
+    // ------------------------------------------------------------------
+    // Returns the shared artifacts for palette + useTransparency, building
+    // them on first use. When the table is full it is emptied first
+    // (artifacts still held by running conversions stay alive).
+    std::shared_ptr<const PaletteArtifacts> intern(const Color *palette, bool useTransparency);
+
+    std::size_t size() const;
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+    void clear();
+
+    // Process-wide table shared by the plugin entry points and the tools
+    static PaletteCache &instance();
+
+private:
+    static std::uint64_t hash(const Color *palette, bool useTransparency);
+
+    mutable std::mutex fLock;
+    std::unordered_map<std::uint64_t, std::vector<std::shared_ptr<const PaletteArtifacts>>> fTable;
+    std::size_t fCount = 0;
+    std::uint64_t fHits = 0;
+    std::uint64_t fMisses = 0;
+};
+
+#endif // PID_PALETTE_H
@@ -0,0 +1,106 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_parallel.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Minimal parallel-for over row bands of one large image
+ *
+ *  DETAILS:
+ *      ParallelFor runs task(0..count-1) on up to `workers` threads, the
+ *      calling thread included, handing out indices from an atomic
+ *      counter. Threads are started per call (the plugin has no pool and
+ *      only very large images take this path); a thread that cannot be
+ *      started simply leaves its share to the others. Each thread uses its
+ *      own ScratchArena / DeflatePool (both thread_local).
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef PID_PARALLEL_H
+#define PID_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+
+// Images below this many pixels are always decoded and encoded on one
+// thread; the banding overhead only pays off for really large ones
+static const std::size_t ParallelMinPixels = 1u << 20;
+
+// Decode band size: about this many pixels per band (whole rows)
+static const std::size_t ParallelBandPixels = 1u << 18;
+
+// Thread count for a workers setting: 0 = one per core
+static inline unsigned ResolveWorkers(unsigned workers)
+{
+    if (workers) return workers;
+    const unsigned cores = std::thread::hardware_concurrency();
+    return cores ? cores : 1;
+}
+
+// ===================================================================
+// ParallelFor
+// - task(i) must return false on failure; an exception counts as one.
+// - Once a task failed the remaining indices are skipped.
+// - Returns true if every task succeeded.
+// ===================================================================
+static inline bool ParallelFor(std::size_t count, unsigned workers, const std::function<bool(std::size_t)> &task)
+{
+    std::atomic<std::size_t> next{ 0 };
+    std::atomic<bool> failed{ false };
+    auto run = [&]() {
+        for (;;)
+        {
+            const std::size_t i = next.fetch_add(1);
+            if (i >= count || failed.load(std::memory_order_relaxed)) return;
+            bool ok = false;
+            try { ok = task(i); }
+            catch (...) { ok = false; }
+            if (!ok) failed.store(true);
+        }
+    };
+
+    const std::size_t threads = (std::min)(static_cast<std::size_t>(ResolveWorkers(workers)), count);
+    std::vector<std::thread> pool;
+    if (threads > 1)
+    {
+        pool.reserve(threads - 1);
+        for (std::size_t t = 1; t < threads; ++t)
+        {
+            try { pool.emplace_back(run); }
+            catch (...) { break; }
+        }
+    }
+    run();
+    for (auto &thread : pool) thread.join();
+    return !failed.load();
+}
+
+#endif // PID_PARALLEL_H
@@ -0,0 +1,229 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_simd.cpp
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      SIMD helpers for the decoder and encoders
+ *
+ *  DETAILS:
+ *      Implementation of the kernels declared in pid_simd.h, including the
+ *      CPUID-based selection between AVX2, SSSE3 and scalar code paths.
+ * ============================================================================
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "pid_simd.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define PID_HAVE_SSE2 1
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define PID_TARGET_SSSE3
+#define PID_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define PID_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define PID_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+
+#ifdef PID_HAVE_SSE2
+// Reverses the 16 bytes of a vector: swap bytes inside 16-bit lanes,
+// then reverse the order of the eight lanes.
+static inline __m128i Reverse16(__m128i v)
+{
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+}
+#endif
+
+void ReverseBytes(unsigned char *data, std::size_t count)
+{
+    std::size_t lo = 0;
+    std::size_t hi = count;
+#ifdef PID_HAVE_SSE2
+    while (hi - lo >= 32)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + lo));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + hi - 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data + lo), Reverse16(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data + hi - 16), Reverse16(a));
+        lo += 16;
+        hi -= 16;
+    }
+#endif
+    std::reverse(data + lo, data + hi);
+}
+
+
+// ===================================================================
+// Palette expansion - scalar
+// ===================================================================
+static void ExpandIndices24_Scalar(const unsigned char *indices, std::size_t count, const std::uint32_t *table, unsigned char *out)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::uint32_t c = table[indices[i]];
+        out[i * 3 + 0] = static_cast<unsigned char>(c);
+        out[i * 3 + 1] = static_cast<unsigned char>(c >> 8);
+        out[i * 3 + 2] = static_cast<unsigned char>(c >> 16);
+    }
+}
+
+static void ExpandIndices32_Scalar(const unsigned char *indices, std::size_t count, const std::uint32_t *table, unsigned char *out)
+{
+    for (std::size_t i = 0; i < count; ++i)
+        std::memcpy(out + i * 4, &table[indices[i]], 4);
+}
+
+#ifdef PID_HAVE_SSE2
+// ===================================================================
+// Palette expansion - SSSE3 (4 pixels per step, pshufb drops byte 3)
+// The 16-byte store leaves 4 garbage bytes that the next step (or the
+// scalar tail) overwrites, so the loop keeps 2 pixels of slack at the end.
+// ===================================================================
+PID_TARGET_SSSE3
+static void ExpandIndices24_SSSE3(const unsigned char *indices, std::size_t count, const std::uint32_t *table, unsigned char *out)
+{
+    const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    std::size_t i = 0;
+    for (; i + 6 <= count; i += 4)
+    {
+        __m128i c = _mm_setr_epi32(static_cast<int>(table[indices[i + 0]]), static_cast<int>(table[indices[i + 1]]),
+                                   static_cast<int>(table[indices[i + 2]]), static_cast<int>(table[indices[i + 3]]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 3), _mm_shuffle_epi8(c, pack));
+    }
+    ExpandIndices24_Scalar(indices + i, count - i, table, out + i * 3);
+}
+
+// ===================================================================
+// Palette expansion - AVX2 (8-wide gather)
+// ===================================================================
+PID_TARGET_AVX2
+static void ExpandIndices32_AVX2(const unsigned char *indices, std::size_t count, const std::uint32_t *table, unsigned char *out)
+{
+    const int *base = reinterpret_cast<const int *>(table);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(indices + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i * 4), _mm256_i32gather_epi32(base, idx, 4));
+    }
+    ExpandIndices32_Scalar(indices + i, count - i, table, out + i * 4);
+}
+
+PID_TARGET_AVX2
+static void ExpandIndices24_AVX2(const unsigned char *indices, std::size_t count, const std::uint32_t *table, unsigned char *out)
+{
+    const int *base = reinterpret_cast<const int *>(table);
+    const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                          0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    std::size_t i = 0;
+    for (; i + 10 <= count; i += 8)
+    {
+        __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(indices + i)));
+        __m256i c = _mm256_shuffle_epi8(_mm256_i32gather_epi32(base, idx, 4), pack);
+        // each 128-bit lane now holds 12 valid bytes (4 pixels)
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 3), _mm256_castsi256_si128(c));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 3 + 12), _mm256_extracti128_si256(c, 1));
+    }
+    ExpandIndices24_Scalar(indices + i, count - i, table, out + i * 3);
+}
+
+// ===================================================================
+// CPU feature detection
+// ===================================================================
+namespace
+{
+    struct CpuFeatures
+    {
+        bool ssse3 = false;
+        bool avx2 = false;
+
+        CpuFeatures()
+        {
+#ifdef _MSC_VER
+            int info[4] = {};
+            __cpuid(info, 0);
+            const int maxLeaf = info[0];
+            __cpuid(info, 1);
+            ssse3 = (info[2] & (1 << 9)) != 0;
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6)
+            {
+                __cpuidex(info, 7, 0);
+                avx2 = (info[1] & (1 << 5)) != 0;
+            }
+#else
+            __builtin_cpu_init();
+            ssse3 = __builtin_cpu_supports("ssse3") != 0;
+            avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+        }
+    };
+
+    const CpuFeatures &Cpu()
+    {
+        static const CpuFeatures features;
+        return features;
+    }
+}
+#endif // PID_HAVE_SSE2
+
+// ===================================================================
+// Dispatch (resolved once)
+// ===================================================================
+typedef void (*ExpandFn)(const unsigned char *, std::size_t, const std::uint32_t *, unsigned char *);
+
+void ExpandIndices24(const unsigned char *indices, std::size_t count, const std::uint32_t *table, unsigned char *out)
+{
+    static const ExpandFn fn = [] {
+#ifdef PID_HAVE_SSE2
+        if (Cpu().avx2) return static_cast<ExpandFn>(ExpandIndices24_AVX2);
+        if (Cpu().ssse3) return static_cast<ExpandFn>(ExpandIndices24_SSSE3);
+#endif
+        return static_cast<ExpandFn>(ExpandIndices24_Scalar);
+    }();
+    fn(indices, count, table, out);
+}
+
+void ExpandIndices32(const unsigned char *indices, std::size_t count, const std::uint32_t *table, unsigned char *out)
+{
+    static const ExpandFn fn = [] {
+#ifdef PID_HAVE_SSE2
+        if (Cpu().avx2) return static_cast<ExpandFn>(ExpandIndices32_AVX2);
+#endif
+        return static_cast<ExpandFn>(ExpandIndices32_Scalar);
+    }();
+    fn(indices, count, table, out);
+}
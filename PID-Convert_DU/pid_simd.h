@@ -0,0 +1,76 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_simd.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      SIMD helpers for the decoder and encoders
+ *
+ *  DETAILS:
+ *      Small vectorized kernels with scalar fallbacks. SSE2 paths are used
+ *      on every x86/x64 target (SSE2 is the baseline of both MSVC targets);
+ *      SSSE3 / AVX2 kernels are selected once at runtime via CPUID.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef PID_SIMD_H
+#define PID_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ------------------------------------------------------------------
+// ReverseBytes()
+// ------------------------------------------------------------------
+// Reverses count bytes in place (used for mirrored rows).
+// - Notes: swaps 16-byte blocks from both ends with SSE2 shuffles,
+//   the (< 32 byte) middle is done with a scalar loop.
+void ReverseBytes(unsigned char *data, std::size_t count);
+
+// ------------------------------------------------------------------
+// ExpandIndices24() / ExpandIndices32()
+// ------------------------------------------------------------------
+// Palette expansion: writes table[indices[i]] for count pixels into out,
+// 3 bytes (first three table bytes) or 4 bytes per pixel.
+// - Parameters:
+//   indices : 8-bit palette indices,
+//   count   : number of pixels,
+//   table   : 256 packed colors, bytes already in output order
+//             (e.g. B,G,R,x for BMP; R,G,B,A for PNG RGBA),
+//   out     : destination, at least count*3 (or count*4) bytes.
+// - Notes: never writes past count*3 / count*4 bytes. Runtime dispatch picks
+//   AVX2 (gather), SSSE3 (pshufb packing) or the scalar loop.
+void ExpandIndices24(const unsigned char *indices, std::size_t count, const std::uint32_t *table, unsigned char *out);
+void ExpandIndices32(const unsigned char *indices, std::size_t count, const std::uint32_t *table, unsigned char *out);
+
+// Packs a color as 4 bytes in memory order b0,b1,b2,b3 (little-endian)
+inline std::uint32_t PackColorBytes(unsigned char b0, unsigned char b1, unsigned char b2, unsigned char b3)
+{
+    return static_cast<std::uint32_t>(b0) | (static_cast<std::uint32_t>(b1) << 8) |
+        (static_cast<std::uint32_t>(b2) << 16) | (static_cast<std::uint32_t>(b3) << 24);
+}
+
+#endif // PID_SIMD_H
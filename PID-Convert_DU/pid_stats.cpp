@@ -0,0 +1,140 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_stats.cpp
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Always-on conversion counters and stage timing
+ *
+ *  DETAILS:
+ *      Implementation of ConvertStats (snapshot / reset / report) and the
+ *      process-wide instance behind instance().
+ * ============================================================================
+ */
+
+#include <cstdarg>
+#include <cstdio>
+#include "pid_stats.h"
+
+
+// ===================================================================
+// Snapshot / reset
+// ===================================================================
+ConvertStats::Snapshot ConvertStats::snapshot() const
+{
+    const auto get = [](const std::atomic<std::uint64_t> &c) { return c.load(std::memory_order_relaxed); };
+
+    Snapshot s;
+    s.hostReads = get(fHostReads);             s.hostReadBytes = get(fHostReadBytes);
+    s.hostWrites = get(fHostWrites);           s.hostWriteBytes = get(fHostWriteBytes);
+    s.hostSeeks = get(fHostSeeks);             s.hostSizeQueries = get(fHostSizeQueries);
+    s.conversions = get(fConversions);         s.failures = get(fFailures);
+    s.imagesDecoded = get(fImagesDecoded);     s.pixelsDecoded = get(fPixelsDecoded);
+    s.mirrored = get(fMirrored);               s.inverted = get(fInverted);
+    s.inputBytes = get(fInputBytes);
+    s.imagesEncoded = get(fImagesEncoded);     s.pixelsEncoded = get(fPixelsEncoded);
+    s.outputBytes = get(fOutputBytes);
+    s.deflateIn = get(fDeflateIn);             s.deflateOut = get(fDeflateOut);
+    for (int i = 0; i < StageCount; ++i)
+    {
+        s.stageNs[i] = get(fStageNs[i]);
+        s.stageCalls[i] = get(fStageCalls[i]);
+    }
+    return s;
+}
+
+void ConvertStats::reset()
+{
+    std::atomic<std::uint64_t> *all[] = {
+        &fHostReads, &fHostReadBytes, &fHostWrites, &fHostWriteBytes, &fHostSeeks, &fHostSizeQueries,
+        &fConversions, &fFailures, &fImagesDecoded, &fPixelsDecoded, &fMirrored, &fInverted, &fInputBytes,
+        &fImagesEncoded, &fPixelsEncoded, &fOutputBytes, &fDeflateIn, &fDeflateOut
+    };
+    for (auto *c : all) c->store(0, std::memory_order_relaxed);
+    for (int i = 0; i < StageCount; ++i)
+    {
+        fStageNs[i].store(0, std::memory_order_relaxed);
+        fStageCalls[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+
+// ===================================================================
+// Report
+// ===================================================================
+namespace
+{
+    // Appends one printf-formatted line
+    void Line(std::string &out, const char *fmt, ...)
+    {
+        char buf[160];
+        va_list args;
+        va_start(args, fmt);
+        const int n = std::vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        if (n > 0) out.append(buf, static_cast<std::size_t>(n) < sizeof(buf) ? static_cast<std::size_t>(n) : sizeof(buf) - 1);
+        out += '\n';
+    }
+
+    double Ms(std::uint64_t ns) { return static_cast<double>(ns) / 1e6; }
+    unsigned long long U(std::uint64_t v) { return static_cast<unsigned long long>(v); }
+}
+
+std::string ConvertStats::report(const Snapshot &s)
+{
+    static const char *const names[StageCount] = { "read", "decode", "encode", "png trials", "png idat" };
+
+    std::string out;
+    Line(out, "Conversions: %llu (%llu failed)", U(s.conversions), U(s.failures));
+
+    if (s.hostReads | s.hostWrites | s.hostSeeks | s.hostSizeQueries)
+    {
+        Line(out, "Host reads: %llu (%llu bytes)", U(s.hostReads), U(s.hostReadBytes));
+        Line(out, "Host writes: %llu (%llu bytes)", U(s.hostWrites), U(s.hostWriteBytes));
+        Line(out, "Host seeks: %llu, size queries: %llu", U(s.hostSeeks), U(s.hostSizeQueries));
+    }
+
+    Line(out, "Decoded: %llu images, %llu pixels from %llu bytes (%llu mirrored, %llu inverted)",
+         U(s.imagesDecoded), U(s.pixelsDecoded), U(s.inputBytes), U(s.mirrored), U(s.inverted));
+    Line(out, "Encoded: %llu images, %llu pixels to %llu bytes", U(s.imagesEncoded), U(s.pixelsEncoded), U(s.outputBytes));
+    if (s.pixelsEncoded)
+        Line(out, "Output: %.3f bytes/pixel", static_cast<double>(s.outputBytes) / static_cast<double>(s.pixelsEncoded));
+    if (s.deflateIn)
+        Line(out, "Deflate: %llu -> %llu bytes (%.1f%%)", U(s.deflateIn), U(s.deflateOut),
+             100.0 * static_cast<double>(s.deflateOut) / static_cast<double>(s.deflateIn));
+
+    for (int i = 0; i < StageCount; ++i)
+    {
+        if (!s.stageCalls[i]) continue;
+        Line(out, "Time %s: %.1f ms in %llu calls", names[i], Ms(s.stageNs[i]), U(s.stageCalls[i]));
+    }
+    return out;
+}
+
+ConvertStats &ConvertStats::instance()
+{
+    static ConvertStats stats;
+    return stats;
+}
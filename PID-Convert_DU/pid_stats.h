@@ -0,0 +1,181 @@
+/*
+MIT License
+
+Copyright (c) 2025 Pawe C. (PaweX3)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+ * ============================================================================
+ *  FILE:       pid_stats.h
+ *  AUTHOR:     Pawe C. (PaweX3)
+ *  LICENSE:    MIT
+ *
+ *  BRIEF:      Always-on conversion counters and stage timing
+ *
+ *  DETAILS:
+ *      DBG_MSG compiles away in release builds, which are the ones that
+ *      run in production. ConvertStats keeps a small set of relaxed atomic
+ *      counters for the whole session (since the DLL / tool was loaded):
+ *      host stream calls and bytes through DelphiTStreamWrapper, images,
+ *      pixels and flips decoded, bytes encoded, deflate input / output and
+ *      the time spent per stage (host read, decode, encode, PNG parameter
+ *      trials, IDAT filter + deflate). report() formats them for AboutBox / the
+ *      config dialog and the CLI --stats flag.
+ * ============================================================================
+ */
+
+#pragma once
+#ifndef PID_STATS_H
+#define PID_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+// =======================
+// Session counters
+// =======================
+class ConvertStats
+{
+public:
+    // Timed stages; Encode includes the Trials and Idat time of PNG
+    // encodes, and (pipelined PNG) the decoding of the rows it consumes
+    enum Stage
+    {
+        StageRead,      // ProbePID + buffering the source from the host
+        StageDecode,    // PidDecoder::decompress, PidScanlineDecoder::validate
+        StageEncode,    // SaveToBMP / SaveToTGA / SaveToTGARLE / SaveToPNG
+        StageTrials,    // ChoosePngParams trial compression
+        StageIdat,      // filtering + deflating the IDAT rows (after the trials)
+        StageCount
+    };
+
+    // Plain copy of every counter, see snapshot()
+    struct Snapshot
+    {
+        std::uint64_t hostReads, hostReadBytes;
+        std::uint64_t hostWrites, hostWriteBytes;
+        std::uint64_t hostSeeks, hostSizeQueries;
+        std::uint64_t conversions, failures;
+        std::uint64_t imagesDecoded, pixelsDecoded, mirrored, inverted, inputBytes;
+        std::uint64_t imagesEncoded, pixelsEncoded, outputBytes;
+        std::uint64_t deflateIn, deflateOut;
+        std::uint64_t stageNs[StageCount];
+        std::uint64_t stageCalls[StageCount];
+    };
+
+    // ------------------------------------------------------------------
+    // Timer
+    // ------------------------------------------------------------------
+    // Adds the lifetime of the object to stage s (one steady_clock read
+    // at each end).
+    class Timer
+    {
+    public:
+        explicit Timer(Stage s) : fStage(s), fStart(std::chrono::steady_clock::now()) {}
+        ~Timer()
+        {
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - fStart).count();
+            ConvertStats::instance().add_time(fStage, static_cast<std::uint64_t>(ns));
+        }
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+
+    private:
+        Stage fStage;
+        std::chrono::steady_clock::time_point fStart;
+    };
+
+    // ------------------------------------------------------------------
+    // Conversion
+    // ------------------------------------------------------------------
+    // Counts one conversion request when it goes out of scope; it is a
+    // failure unless the result was passed through done() as 0.
+    class Conversion
+    {
+    public:
+        Conversion() = default;
+        ~Conversion() { ConvertStats::instance().conversion(fOk); }
+        Conversion(const Conversion &) = delete;
+        Conversion &operator=(const Conversion &) = delete;
+
+        int done(int result) { fOk = (result == 0); return result; }
+
+    private:
+        bool fOk = false;
+    };
+
+    void host_read(std::size_t bytes)   { add(fHostReads, 1); add(fHostReadBytes, bytes); }
+    void host_write(std::size_t bytes)  { add(fHostWrites, 1); add(fHostWriteBytes, bytes); }
+    void host_seek()                    { add(fHostSeeks, 1); }
+    void host_size()                    { add(fHostSizeQueries, 1); }
+
+    void conversion(bool ok)            { add(fConversions, 1); if (!ok) add(fFailures, 1); }
+    void decoded(std::uint64_t pixels, std::size_t inputBytes, bool mirror, bool invert)
+    {
+        add(fImagesDecoded, 1);
+        add(fPixelsDecoded, pixels);
+        add(fInputBytes, inputBytes);
+        if (mirror) add(fMirrored, 1);
+        if (invert) add(fInverted, 1);
+    }
+    void encoded(std::uint64_t pixels, std::uint64_t outputBytes)
+    {
+        add(fImagesEncoded, 1);
+        add(fPixelsEncoded, pixels);
+        add(fOutputBytes, outputBytes);
+    }
+    void deflated(std::size_t in, std::size_t out) { add(fDeflateIn, in); add(fDeflateOut, out); }
+
+    void add_time(Stage s, std::uint64_t ns)     { add(fStageNs[s], ns); add(fStageCalls[s], 1); }
+
+    Snapshot snapshot() const;
+    void reset();
+
+    // ------------------------------------------------------------------
+    // report()
+    // ------------------------------------------------------------------
+    // Multi-line, human-readable summary of a snapshot (lines end in '\n').
+    // Host counters are left out when no host stream was used (tools).
+    static std::string report(const Snapshot &s);
+
+    // Process-wide counters shared by the plugin entry points and the tools
+    static ConvertStats &instance();
+
+private:
+    static void add(std::atomic<std::uint64_t> &counter, std::uint64_t value)
+    {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    std::atomic<std::uint64_t> fHostReads{ 0 }, fHostReadBytes{ 0 };
+    std::atomic<std::uint64_t> fHostWrites{ 0 }, fHostWriteBytes{ 0 };
+    std::atomic<std::uint64_t> fHostSeeks{ 0 }, fHostSizeQueries{ 0 };
+    std::atomic<std::uint64_t> fConversions{ 0 }, fFailures{ 0 };
+    std::atomic<std::uint64_t> fImagesDecoded{ 0 }, fPixelsDecoded{ 0 }, fMirrored{ 0 }, fInverted{ 0 }, fInputBytes{ 0 };
+    std::atomic<std::uint64_t> fImagesEncoded{ 0 }, fPixelsEncoded{ 0 }, fOutputBytes{ 0 };
+    std::atomic<std::uint64_t> fDeflateIn{ 0 }, fDeflateOut{ 0 };
+    std::atomic<std::uint64_t> fStageNs[StageCount] = {};
+    std::atomic<std::uint64_t> fStageCalls[StageCount] = {};
+};
+
+#endif // PID_STATS_H
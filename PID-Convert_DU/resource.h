@@ -6,6 +6,11 @@
 #define IDC_RADIO_PNG8                  1001
 #define IDC_RADIO_PNG24                 1002
 #define IDC_RADIO_PNG32                 1003
+#define IDC_RADIO_PNG_FAST              1004
+#define IDC_RADIO_PNG_BALANCED          1005
+#define IDC_RADIO_PNG_SMALLEST          1006
+#define IDC_EDIT_CACHE_MB               1007
+#define IDC_BUTTON_STATS                1008
 
 // Next default values for new objects
 // 
@@ -13,7 +18,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        107
 #define _APS_NEXT_COMMAND_VALUE         40001
-#define _APS_NEXT_CONTROL_VALUE         1004
+#define _APS_NEXT_CONTROL_VALUE         1009
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif